@@ -0,0 +1,95 @@
+#pragma once
+
+#include <catch.h>
+
+#include <ECS.h>
+#include <ECS/ChangeTracker.h>
+#include <ECS/DomainSnapshot.h>
+
+#include "TestComponents.h"
+#include "Log.h"
+
+
+
+TEST_CASE("Tracking Domain changes", "[change_tracker]") {
+
+	River::ECS::Domain domain;
+	std::vector<River::ECS::Entity*> entities;
+	for( int i = 0; i < 10; i++ ) {
+		auto entity = domain.createEntity();
+		entity->addComponent<ComponentA>();
+		entities.push_back(entity);
+	}
+	domain.clean();
+
+	River::ECS::ChangeTracker tracker(domain);
+	REQUIRE(tracker.getChangedEntities().empty());
+	REQUIRE(tracker.getDestroyedEntities().empty());
+	REQUIRE(!tracker.isAllChanged());
+
+
+	SECTION("Cleaned changes are tracked") {
+		auto newEntity = domain.createEntity();
+		entities[1]->addComponent<ComponentB>();
+		entities[2]->removeComponent<ComponentA>();
+		auto destroyedId = entities[3]->getId();
+		entities[3]->destroy();
+
+		// Structural changes are recorded when cleaning
+		REQUIRE(tracker.getChangedEntities().empty());
+		domain.clean();
+
+		REQUIRE(tracker.getChangedEntities().size() == 3);
+		REQUIRE(tracker.getChangedEntities().count(newEntity) == 1);
+		REQUIRE(tracker.getChangedEntities().count(entities[1]) == 1);
+		REQUIRE(tracker.getChangedEntities().count(entities[2]) == 1);
+		REQUIRE(tracker.getDestroyedEntities().size() == 1);
+		REQUIRE(tracker.getDestroyedEntities()[0] == destroyedId);
+
+		tracker.reset();
+		REQUIRE(tracker.getChangedEntities().empty());
+		REQUIRE(tracker.getDestroyedEntities().empty());
+	}
+
+
+	SECTION("Marked writes are tracked") {
+		entities[4]->getComponent<ComponentA>()->a = 1;
+		entities[5]->getComponent<ComponentA>()->a = 1;
+		entities[5]->markChanged();
+
+		REQUIRE(tracker.getChangedEntities().size() == 1);
+		REQUIRE(tracker.getChangedEntities().count(entities[5]) == 1);
+	}
+
+
+	SECTION("Destroyed entities aren't changed entities") {
+		entities[6]->markChanged();
+		entities[6]->destroy();
+		domain.clean();
+
+		REQUIRE(tracker.getChangedEntities().empty());
+		REQUIRE(tracker.getDestroyedEntities().size() == 1);
+	}
+
+
+	SECTION("Restoring a snapshot changes all entities") {
+		River::ECS::DomainSnapshot snapshot(domain);
+		domain.snapshot(snapshot);
+		entities[7]->markChanged();
+		domain.restore(snapshot);
+
+		REQUIRE(tracker.isAllChanged());
+		REQUIRE(tracker.getChangedEntities().empty());
+
+		tracker.reset();
+		REQUIRE(!tracker.isAllChanged());
+	}
+
+
+	SECTION("Multiple trackers") {
+		River::ECS::ChangeTracker secondTracker(domain);
+		entities[8]->markChanged();
+		REQUIRE(tracker.getChangedEntities().size() == 1);
+		REQUIRE(secondTracker.getChangedEntities().size() == 1);
+	}
+}
@@ -120,6 +120,25 @@ TEST_CASE("Component Controller Tests", "[component_controller]") {
 
 		checkEntities(controller, entities, expectedComponents);
 	}
+
+	SECTION("Delete - Batch") {
+		// Delete every third entity in one call (with a duplicate)
+		std::vector<River::ECS::Entity*> entitiesToDelete;
+		for( int i = NUM_ENTITIES - 1; i >= 0; i -= 3 ) {
+			entitiesToDelete.push_back(entities.at(i));
+			expectedComponents.erase(entities.at(i));
+			entities.erase(entities.begin() + i);
+		}
+		entitiesToDelete.push_back(entitiesToDelete.front());
+
+		controller.deleteEntityComponents(entitiesToDelete.data(), entitiesToDelete.size());
+		controller.clean();
+
+		for( auto entity : entitiesToDelete )
+			REQUIRE(controller.getComponent(entity) == nullptr);
+		REQUIRE(controller.getNumComponents() == NUM_ENTITIES - NUM_ENTITIES / 3);
+		checkEntities(controller, entities, expectedComponents);
+	}
 }
 
 
@@ -0,0 +1,151 @@
+#pragma once
+
+#include <catch.h>
+
+#include <ECS.h>
+#include <ECS/ComponentFields.h>
+#include <ECS/DomainSnapshot.h>
+
+#include "Log.h"
+
+
+
+struct SoAComponent : public River::ECS::Component {
+	float x = 1;
+	float y = 2;
+	int i = 3;
+	int notStored = 4;
+};
+
+RV_ECS_COMPONENT_FIELDS(SoAComponent, &SoAComponent::x, &SoAComponent::y, &SoAComponent::i);
+
+static_assert(River::ECS::ComponentFields<SoAComponent>::IS_SOA, "Component type is stored as a structure of arrays");
+static_assert(std::is_same<River::ECS::ComponentPointer<SoAComponent>, River::ECS::ComponentFieldsRef<SoAComponent>>::value, "Structure of arrays type is handed out as a ComponentFieldsRef");
+
+
+
+TEST_CASE("Structure of arrays components", "[component_fields]") {
+
+	River::ECS::Domain domain;
+
+	std::vector<River::ECS::Entity*> entities;
+	for( int i = 0; i < 100; i++ ) {
+		auto entity = domain.createEntity();
+		auto component = entity->addComponent<SoAComponent>();
+		component->x = (float)i;
+		component->i = i * 2;
+		component->notStored = i;
+		entities.push_back(entity);
+	}
+
+	// New components are stored as whole components until cleaning
+	REQUIRE(entities[5]->getComponent<SoAComponent>().load().notStored == 5);
+
+	domain.clean();
+
+
+	SECTION("Field access") {
+		for( int i = 0; i < 100; i++ ) {
+			auto component = entities[i]->getComponent<SoAComponent>();
+			REQUIRE(component != nullptr);
+			REQUIRE(component.get<&SoAComponent::x>() == (float)i);
+			REQUIRE(component.get<&SoAComponent::y>() == 2);
+			REQUIRE(component.get<&SoAComponent::i>() == i * 2);
+
+			auto value = component.load();
+			REQUIRE(value.i == i * 2);
+			REQUIRE(value.notStored == 4); // Fields which aren't stored have their default value
+		}
+
+		auto component = entities[10]->getComponent<SoAComponent>();
+		SoAComponent value;
+		value.x = 100;
+		component.store(value);
+		REQUIRE(component.get<&SoAComponent::x>() == 100);
+		REQUIRE(component.getId() == entities[10]->getComponent<SoAComponent>().getId());
+	}
+
+
+	SECTION("Field arrays") {
+		auto components = domain.getComponentRef<SoAComponent>();
+		float* x = components.getField<&SoAComponent::x>();
+		float* y = components.getField<&SoAComponent::y>();
+		REQUIRE(reinterpret_cast<uintptr_t>(x) % River::ECS::FIELD_ARRAY_ALIGNMENT == 0);
+
+		for( unsigned int i = 0; i < components.size(); i++ )
+			y[i] = x[i] + 1;
+
+		for( int i = 0; i < 100; i++ ) {
+			unsigned int index = components.getIndex(entities[i]);
+			REQUIRE(components[index].get<&SoAComponent::y>() == (float)i + 1);
+			REQUIRE(entities[i]->getComponent<SoAComponent>().get<&SoAComponent::y>() == (float)i + 1);
+		}
+	}
+
+
+	SECTION("Removal and queries") {
+		for( int i = 0; i < 100; i += 3 )
+			entities[i]->removeComponent<SoAComponent>();
+		domain.clean();
+
+		// New components after removals (the field arrays have room for them)
+		auto entity = domain.createEntity();
+		entity->addComponent<SoAComponent>()->x = -1;
+		REQUIRE(entity->getComponent<SoAComponent>().get<&SoAComponent::x>() == -1);
+		domain.clean();
+
+		int numMatches = 0;
+		domain.forMatchingEntities<SoAComponent>([&](River::ECS::Entity* e, River::ECS::ComponentFieldsRef<SoAComponent> component) {
+			REQUIRE(component.get<&SoAComponent::i>() == (e == entity ? 3 : (int)component.get<&SoAComponent::x>() * 2));
+			numMatches++;
+		});
+		REQUIRE(numMatches == 100 - 34 + 1);
+
+		for( int i = 0; i < 100; i++ )
+			REQUIRE((entities[i]->getComponent<SoAComponent>() == nullptr) == (i % 3 == 0));
+	}
+
+
+	SECTION("Snapshot and clone") {
+		River::ECS::DomainSnapshot snapshot(domain);
+		domain.snapshot(snapshot);
+		entities[0]->getComponent<SoAComponent>().get<&SoAComponent::x>() = 50;
+		domain.restore(snapshot);
+		REQUIRE(entities[0]->getComponent<SoAComponent>().get<&SoAComponent::x>() == 0);
+
+		auto clone = domain.clone();
+		clone->forMatchingEntities<SoAComponent>([](River::ECS::Entity* e, River::ECS::ComponentFieldsRef<SoAComponent> component) {
+			REQUIRE(component.get<&SoAComponent::i>() == (int)component.get<&SoAComponent::x>() * 2);
+		});
+		delete clone;
+	}
+}
+
+
+
+struct AlignedComponent : public River::ECS::Component {
+	float x, y, z;
+};
+
+RV_ECS_COMPONENT_ALIGNMENT(AlignedComponent, 64);
+
+
+
+TEST_CASE("Component alignment", "[component_fields]") {
+
+	River::ECS::Domain domain;
+	for( int i = 0; i < 10; i++ )
+		domain.createEntity()->addComponent<AlignedComponent>();
+	domain.clean();
+
+	auto components = domain.getComponentRef<AlignedComponent>();
+	REQUIRE(components.size() == 10);
+	REQUIRE(reinterpret_cast<uintptr_t>(&components[0]) % 64 == 0);
+
+	// 16 byte components from the start of a cache line
+#ifdef RV_ECS_ENABLE_STATISTICS
+	auto& statistics = domain.getStatistics().componentTypes.at(River::ECS::ComponentTypeRegistry::getTypeId<AlignedComponent>());
+	REQUIRE(statistics.straddlingComponents == 0);
+	REQUIRE(statistics.cacheLines == 3);
+#endif
+}
@@ -0,0 +1,88 @@
+#pragma once
+
+#include <catch.h>
+
+#include <ECS.h>
+#include <ECS/ComponentRef.h>
+
+#include "TestComponents.h"
+#include "Log.h"
+
+
+
+TEST_CASE("Component refs", "[component_ref]") {
+
+	River::ECS::Domain domain;
+
+	std::vector<River::ECS::Entity*> entities;
+	for( int i = 0; i < 100; i++ ) {
+		auto entity = domain.createEntity();
+		entity->addComponent<ComponentA>()->a = i;
+		if( i % 2 == 0 )
+			entity->addComponent<ComponentB>()->a = i * 2;
+		entities.push_back(entity);
+	}
+	domain.clean();
+
+	auto [refA, refB] = domain.getComponentRefs<ComponentA, ComponentB>();
+	REQUIRE(refA.size() == 100);
+	REQUIRE(refB.size() == 50);
+
+
+	SECTION("Access by index") {
+		for( int i = 0; i < 100; i++ ) {
+			auto entity = entities[i];
+
+			unsigned int indexA = refA.getIndex(entity);
+			REQUIRE(indexA != River::ECS::ComponentRef<ComponentA>::NO_INDEX);
+			REQUIRE(&refA[indexA] == entity->getComponent<ComponentA>());
+			REQUIRE(refA[indexA].a == i);
+
+			unsigned int indexB = refB.getIndex(entity);
+			if( i % 2 == 0 ) {
+				REQUIRE(refB[indexB].a == i * 2);
+				REQUIRE(refB.get(entity) == entity->getComponent<ComponentB>());
+			} else {
+				REQUIRE(indexB == River::ECS::ComponentRef<ComponentB>::NO_INDEX);
+				REQUIRE(refB.get(entity) == nullptr);
+			}
+		}
+	}
+
+
+	SECTION("Changes before cleaning") {
+		unsigned int index = refA.getIndex(entities[10]);
+
+		// Removed components and destroyed entities keep their index until the Domain is cleaned
+		entities[10]->removeComponent<ComponentA>();
+		entities[20]->destroy();
+		REQUIRE(refA[index].a == 10);
+		REQUIRE(refA.get(entities[20])->a == 20);
+
+		// New components may not have an index before cleaning
+		auto entity = domain.createEntity();
+		entity->addComponent<ComponentA>();
+		auto a = refA.get(entity);
+		REQUIRE((a == nullptr || a == entity->getComponent<ComponentA>()));
+	}
+
+
+	SECTION("Component type which hasn't been used") {
+		auto refC = domain.getComponentRef<ComponentC>();
+		REQUIRE(refC.size() == 0);
+		REQUIRE(refC.get(entities[0]) == nullptr);
+	}
+
+
+#ifdef RV_ECS_CHECK_COMPONENT_REFS
+	SECTION("Invalid after cleaning") {
+		domain.clean();
+		REQUIRE_THROWS_AS(refA.getIndex(entities[0]), River::ECS::InvalidComponentRefException);
+		REQUIRE_THROWS_AS(refA[0], River::ECS::InvalidComponentRefException);
+
+		auto newRefA = domain.getComponentRef<ComponentA>();
+		REQUIRE(newRefA.get(entities[0])->a == 0);
+		REQUIRE_THROWS_AS(newRefA[100], std::out_of_range);
+	}
+#endif
+}
@@ -0,0 +1,85 @@
+#pragma once
+
+#include <catch.h>
+
+#include <thread>
+#include <set>
+#include <utility>
+
+#include <ECS.h>
+
+#include "TestComponents.h"
+#include "Log.h"
+
+
+
+// Component types which are only used in these tests
+template <int N>
+struct RegistryComponent : public River::ECS::Component {
+	int value = N;
+};
+
+
+// Gets the type ids of RegistryComponent<0> to RegistryComponent<N-1>
+template <int ... N>
+std::vector<River::ECS::ComponentTypeId> getRegistryComponentTypeIds(std::integer_sequence<int, N...>) {
+	return { River::ECS::ComponentTypeRegistry::getTypeId<RegistryComponent<N>>()... };
+}
+
+
+
+TEST_CASE("Registering component types from multiple threads", "[component_type_registry]") {
+
+	auto numTypesBefore = River::ECS::ComponentTypeRegistry::getNumTypes();
+
+	const int NUM_THREADS = 8;
+	std::vector<std::vector<River::ECS::ComponentTypeId>> threadTypeIds(NUM_THREADS);
+	std::vector<std::thread> threads;
+	for( int i = 0; i < NUM_THREADS; i++ ) {
+		threads.emplace_back([&threadTypeIds, i]() {
+			threadTypeIds[i] = getRegistryComponentTypeIds(std::make_integer_sequence<int, 50>());
+		});
+	}
+	for( auto& thread : threads )
+		thread.join();
+
+	// All threads get the same ids, and each type has its own id
+	for( int i = 1; i < NUM_THREADS; i++ )
+		REQUIRE(threadTypeIds[i] == threadTypeIds[0]);
+
+	std::set<River::ECS::ComponentTypeId> uniqueTypeIds(threadTypeIds[0].begin(), threadTypeIds[0].end());
+	REQUIRE(uniqueTypeIds.size() == 50);
+	REQUIRE(*uniqueTypeIds.begin() >= numTypesBefore);
+	REQUIRE(River::ECS::ComponentTypeRegistry::getNumTypes() == numTypesBefore + 50);
+}
+
+
+
+TEST_CASE("Registering component types up front", "[component_type_registry]") {
+
+	auto numTypesBefore = River::ECS::ComponentTypeRegistry::getNumTypes();
+	River::ECS::ComponentTypeRegistry::registerComponents<RegistryComponent<100>, RegistryComponent<101>, RegistryComponent<102>>();
+	REQUIRE(River::ECS::ComponentTypeRegistry::getNumTypes() == numTypesBefore + 3);
+	REQUIRE(River::ECS::ComponentTypeRegistry::getTypeId<RegistryComponent<100>>() == numTypesBefore);
+	REQUIRE(River::ECS::ComponentTypeRegistry::getTypeId<RegistryComponent<102>>() == numTypesBefore + 2);
+
+	// Registering again doesn't change the ids
+	River::ECS::ComponentTypeRegistry::registerComponents<RegistryComponent<102>, RegistryComponent<100>>();
+	REQUIRE(River::ECS::ComponentTypeRegistry::getNumTypes() == numTypesBefore + 3);
+	REQUIRE(River::ECS::ComponentTypeRegistry::getTypeId<RegistryComponent<100>>() == numTypesBefore);
+
+	River::ECS::Domain domain;
+	domain.registerComponents<RegistryComponent<101>, RegistryComponent<103>>();
+	REQUIRE(domain.getNumComponentTypes() == 2);
+
+	domain.createEntity()->addComponent<RegistryComponent<103>>();
+	domain.clean();
+	REQUIRE(domain.getNumComponentTypes() == 2);
+
+	int entityCount = 0;
+	domain.forMatchingEntities<RegistryComponent<103>>([&entityCount](auto entity, auto component) {
+		REQUIRE(component->value == 103);
+		entityCount++;
+		});
+	REQUIRE(entityCount == 1);
+}
@@ -0,0 +1,245 @@
+#pragma once
+
+#include <catch.h>
+
+#include <ECS.h>
+#include <ECS/DomainSnapshot.h>
+
+#include "TestComponents.h"
+#include "Log.h"
+
+
+// Counts the number of entities matching the component types
+template <typename ... C>
+int countMatchingEntities(River::ECS::Domain& domain) {
+	int count = 0;
+	domain.forMatchingEntities<C...>([&count](auto entity, auto ... components) {
+		count++;
+	});
+	return count;
+}
+
+
+
+TEST_CASE("Restoring Domain snapshot", "[domain_snapshot]") {
+
+	River::ECS::Domain domain;
+	std::vector<River::ECS::Entity*> entities;
+
+	for( int i = 0; i < 50; i++ ) {
+		auto entity = domain.createEntity();
+		entity->addComponent<ComponentA>()->a = i;
+		if( i % 2 == 0 )
+			entity->addComponent<ComponentB>()->c = "Entity " + std::to_string(i);
+		entities.push_back(entity);
+	}
+	domain.clean();
+
+	River::ECS::DomainSnapshot snapshot(domain);
+	REQUIRE(!snapshot.isStored());
+	domain.snapshot(snapshot);
+	REQUIRE(snapshot.isStored());
+
+	auto checkRestored = [&]() {
+		REQUIRE(domain.getNumEntities() == 50);
+		REQUIRE(countMatchingEntities<ComponentA>(domain) == 50);
+		REQUIRE(countMatchingEntities<ComponentA, ComponentB>(domain) == 25);
+		REQUIRE(countMatchingEntities<ComponentC>(domain) == 0);
+		for( int i = 0; i < 50; i++ ) {
+			REQUIRE(entities[i]->getComponent<ComponentA>()->a == i);
+			if( i % 2 == 0 )
+				REQUIRE(entities[i]->getComponent<ComponentB>()->c == "Entity " + std::to_string(i));
+			else
+				REQUIRE(entities[i]->getComponent<ComponentB>() == nullptr);
+		}
+	};
+
+
+	SECTION("Modified components") {
+		for( auto entity : entities )
+			entity->getComponent<ComponentA>()->a = -1;
+		entities[0]->getComponent<ComponentB>()->c = "Modified";
+
+		domain.restore(snapshot);
+		checkRestored();
+	}
+
+
+	SECTION("Created and destroyed entities and components") {
+		entities[3]->destroy();
+		entities[10]->destroy();
+		entities[4]->removeComponent<ComponentB>();
+		entities[5]->addComponent<ComponentB>();
+		entities[6]->addComponent<ComponentC>();
+		domain.createEntity()->addComponent<ComponentA>();
+		domain.clean();
+
+		REQUIRE(domain.getNumEntities() == 49);
+
+		// Uncleaned changes are discarded as well
+		domain.createEntity()->addComponent<ComponentA>();
+		entities[20]->destroy();
+
+		domain.restore(snapshot);
+		checkRestored();
+
+		// Domain is still usable after restoring
+		entities[3]->destroy();
+		domain.createEntity()->addComponent<ComponentA>();
+		domain.clean();
+		REQUIRE(domain.getNumEntities() == 50);
+		REQUIRE(countMatchingEntities<ComponentA>(domain) == 50);
+	}
+
+
+	SECTION("Restoring multiple times") {
+		for( int i = 0; i < 3; i++ ) {
+			entities[i]->destroy();
+			entities[i + 10]->getComponent<ComponentA>()->a = 100;
+			domain.clean();
+
+			domain.restore(snapshot);
+			checkRestored();
+		}
+	}
+
+
+	SECTION("Snapshot requires clean domain") {
+		domain.createEntity();
+		REQUIRE_THROWS_AS(domain.snapshot(snapshot), River::ECS::DomainNotCleanException);
+	}
+}
+
+
+
+TEST_CASE("Reused snapshot doesn't keep destroyed entities", "[domain_snapshot]") {
+
+	River::ECS::Domain domain;
+	std::vector<River::ECS::Entity*> entities;
+	auto getNumEntityObjects = [&domain]() {
+		return domain.memoryReport().structures.at("entityObjects").usedBytes / sizeof(River::ECS::Entity);
+	};
+
+	River::ECS::DomainSnapshot snapshot(domain);
+	River::ECS::DomainSnapshot firstSnapshot(domain);
+
+	// Each frame replaces all entities, and stores the snapshot again
+	for( int frame = 0; frame < 100; frame++ ) {
+		for( auto entity : entities )
+			entity->destroy();
+		entities.clear();
+		for( int i = 0; i < 10; i++ ) {
+			auto entity = domain.createEntity();
+			entity->addComponent<ComponentA>()->a = frame;
+			entities.push_back(entity);
+		}
+		domain.clean();
+
+		// The destroyed entities are only kept until the snapshot no longer refers to them
+		REQUIRE(getNumEntityObjects() <= 20 + (frame > 0 ? 10 : 0));
+		domain.snapshot(snapshot);
+		if( frame == 0 )
+			domain.snapshot(firstSnapshot);
+		REQUIRE(getNumEntityObjects() == (frame > 0 ? 20 : 10));
+	}
+
+	// The entities of the first frame are still kept by the other snapshot
+	for( auto entity : entities )
+		entity->destroy();
+	domain.clean();
+	domain.restore(firstSnapshot);
+	REQUIRE(domain.getNumEntities() == 10);
+	domain.forMatchingEntities<ComponentA>([](River::ECS::Entity* entity, ComponentA* a) {
+		REQUIRE(a->a == 0);
+	});
+
+	domain.restore(snapshot);
+	REQUIRE(domain.getNumEntities() == 10);
+	REQUIRE(domain.getEntityComponent<ComponentA>(entities[0])->a == 99);
+	REQUIRE(getNumEntityObjects() == 20);
+}
+
+
+
+TEST_CASE("Cloning Domain", "[domain_snapshot]") {
+
+	River::ECS::Domain domain;
+
+	for( int i = 0; i < 20; i++ ) {
+		auto entity = domain.createEntity();
+		entity->addComponent<ComponentA>()->a = i;
+		if( i % 4 == 0 )
+			entity->addComponent<ComponentC>();
+	}
+	domain.clean();
+
+	River::ECS::Domain* clone = domain.clone();
+
+	REQUIRE(clone->getNumEntities() == 20);
+	REQUIRE(countMatchingEntities<ComponentA>(*clone) == 20);
+	REQUIRE(countMatchingEntities<ComponentA, ComponentC>(*clone) == 5);
+
+	clone->forEachEntity([clone](River::ECS::Entity* entity) {
+		REQUIRE(&entity->getDomain() == clone);
+		REQUIRE(entity->getComponent<ComponentA>()->a == (int)entity->getId() - 1);
+		entity->getComponent<ComponentA>()->a = -1;
+	});
+
+	// Modifying the clone doesn't change the original Domain
+	clone->forEachEntity([](River::ECS::Entity* entity) {
+		entity->destroy();
+	});
+	clone->clean();
+	REQUIRE(clone->getNumEntities() == 0);
+
+	REQUIRE(domain.getNumEntities() == 20);
+	domain.forEachEntity([&domain](River::ECS::Entity* entity) {
+		REQUIRE(&entity->getDomain() == &domain);
+		REQUIRE(entity->getComponent<ComponentA>()->a == (int)entity->getId() - 1);
+	});
+
+	delete clone;
+}
+
+
+
+TEST_CASE("Cloning Domain with destroyed entities", "[domain_snapshot]") {
+
+	River::ECS::Domain domain;
+	River::ECS::DomainSnapshot snapshot(domain);
+
+	std::vector<River::ECS::Entity*> entities;
+	for( int i = 0; i < 20; i++ ) {
+		auto entity = domain.createEntity();
+		entity->addComponent<ComponentA>()->a = i;
+		entities.push_back(entity);
+	}
+	domain.clean();
+	domain.snapshot(snapshot);
+
+	// The snapshot keeps the destroyed entities alive (retired), and the entities after them are created in
+	// other slots than the clone's entities would get in order
+	for( int i = 0; i < 20; i += 3 )
+		entities[i]->destroy();
+	domain.clean();
+	for( int i = 0; i < 5; i++ )
+		domain.createEntity()->addComponent<ComponentA>()->a = 100 + i;
+	domain.clean();
+
+	River::ECS::Domain* clone = domain.clone();
+	REQUIRE(clone->getNumEntities() == 18);
+	REQUIRE(countMatchingEntities<ComponentA>(*clone) == 18);
+
+	// Entities created in the clone don't share slots with the cloned entities
+	for( int i = 0; i < 10; i++ )
+		clone->createEntity()->addComponent<ComponentA>()->a = 200 + i;
+	clone->clean();
+	REQUIRE(countMatchingEntities<ComponentA>(*clone) == 28);
+
+	clone->forEachEntity([](River::ECS::Entity* entity) {
+		int expected = entity->getId() <= 20 ? (int)entity->getId() - 1 : entity->getId() <= 25 ? 100 + (int)entity->getId() - 21 : 200 + (int)entity->getId() - 26;
+		REQUIRE(entity->getComponent<ComponentA>()->a == expected);
+	});
+
+	delete clone;
+}
@@ -154,8 +154,10 @@ TEST_CASE("General Signature search", "[entity]") {
 		components works
 	*/
 	
+	River::ECS::DomainSettings settings;
+	settings.signatureLayout = GENERATE(River::ECS::SignatureLayout::RowMajor, River::ECS::SignatureLayout::ColumnMajor);
 
-	River::ECS::Domain domain;
+	River::ECS::Domain domain(settings);
 	River::ECS::Entity* entity;
 
 	entity = domain.createEntity();
@@ -225,6 +227,108 @@ TEST_CASE("General Signature search", "[entity]") {
 
 
 
+// ==============================================================================================================================================================================================
+TEST_CASE("Signature search with many matches", "[entity]") {
+	/*	Checking that queries with more matches than are looked up
+		at a time, give the right components (also when the callbacks
+		make changes to the Domain)
+	*/
+
+	River::ECS::Domain domain;
+	for( int i = 0; i < 1000; i++ ) {
+		auto entity = domain.createEntity();
+		entity->addComponent<ComponentA>()->a = i;
+		if( i % 3 != 0 )
+			entity->addComponent<ComponentB>()->a = i;
+	}
+	domain.clean();
+
+	int entityCount = 0;
+	domain.forMatchingEntities<ComponentA, ComponentB>([&](River::ECS::Entity* entity, ComponentA* a, ComponentB* b) {
+		REQUIRE(a == entity->getComponent<ComponentA>());
+		REQUIRE(b == entity->getComponent<ComponentB>());
+		REQUIRE(a->a == b->a);
+
+		// Changes made during the query
+		domain.createEntity()->addComponent<ComponentA>();
+		entity->addComponent<ComponentC>();
+		if( a->a % 2 == 0 )
+			entity->destroy();
+		entityCount++;
+	});
+	REQUIRE(entityCount == 666);
+
+	domain.clean();
+	entityCount = 0;
+	domain.forMatchingEntities<ComponentA, ComponentB, ComponentC>([&entityCount](auto entity, auto a, auto b, auto c) {
+		REQUIRE(a->a % 2 == 1);
+		entityCount++;
+	});
+	REQUIRE(entityCount == 333);
+}
+
+
+
+
+// ==============================================================================================================================================================================================
+TEST_CASE("Signature search after destroying entities", "[entity]") {
+	/*	Destroying entities moves the last signatures into their places,
+		which must keep the signatures matched to the right entities
+		(also in clones of the Domain)
+	*/
+
+	River::ECS::Domain domain;
+	std::vector<River::ECS::Entity*> entities;
+	for( int i = 0; i < 100; i++ ) {
+		auto entity = domain.createEntity();
+		entity->addComponent<ComponentA>()->a = i;
+		if( i % 2 == 0 )
+			entity->addComponent<ComponentB>()->a = i;
+		entities.push_back(entity);
+	}
+	domain.clean();
+
+	// Destroying entities from the front, so the signatures of the last ones are moved
+	for( int i = 0; i < 100; i += 4 )
+		entities[i]->destroy();
+	domain.clean();
+
+	std::vector<int> order;
+	domain.forEachEntity([&order](River::ECS::Entity* entity) {
+		order.push_back(entity->getComponent<ComponentA>()->a);
+	});
+	REQUIRE(order.size() == 75);
+	REQUIRE(std::is_sorted(order.begin(), order.end()));
+
+	auto checkMatches = [](River::ECS::Domain& domain) {
+		int entityCount = 0;
+		domain.forMatchingEntities<ComponentA, ComponentB>([&entityCount](River::ECS::Entity* entity, ComponentA* a, ComponentB* b) {
+			REQUIRE(a == entity->getComponent<ComponentA>());
+			REQUIRE(b == entity->getComponent<ComponentB>());
+			REQUIRE(a->a == b->a);
+			REQUIRE(a->a % 4 == 2);
+			entityCount++;
+		});
+		REQUIRE(entityCount == 25);
+	};
+	checkMatches(domain);
+
+	auto clone = domain.clone();
+	checkMatches(*clone);
+
+	// Destroying entities in the clone doesn't affect the original
+	clone->forEachEntity([](River::ECS::Entity* entity) {
+		entity->destroy();
+	});
+	clone->clean();
+	REQUIRE(clone->getNumEntities() == 0);
+	checkMatches(domain);
+	delete clone;
+}
+
+
+
+
 // ==============================================================================================================================================================================================
 TEST_CASE("Non-existing Component signature search", "[entity]") {
 	/*	Querying entities with components that no entity has yet.
@@ -268,6 +372,85 @@ TEST_CASE("Non-existing Component signature search", "[entity]") {
 
 
 
+// ==============================================================================================================================================================================================
+TEST_CASE("Signatures of multiple Domains", "[entity]") {
+	/*	Each Domain only has signature bits for the component types it uses,
+		regardless of the types used by other Domains.
+	*/
+
+	River::ECS::Domain bigDomain;
+	auto bigEntity = bigDomain.createEntity();
+	bigEntity->addComponent<ComponentE>();
+	bigEntity->addComponent<ComponentD>();
+	bigEntity->addComponent<ComponentC>();
+	bigEntity->addComponent<ComponentB>();
+	bigDomain.clean();
+	REQUIRE(bigDomain.getNumComponentTypes() == 4);
+
+	River::ECS::Domain smallDomain;
+	REQUIRE(smallDomain.getNumComponentTypes() == 0);
+	for( int i = 0; i < 10; i++ ) {
+		auto entity = smallDomain.createEntity();
+		entity->addComponent<ComponentD>();
+		if( i % 2 == 0 )
+			entity->addComponent<ComponentB>();
+	}
+	smallDomain.clean();
+	REQUIRE(smallDomain.getNumComponentTypes() == 2);
+
+	// The signatures are a single word wide, no matter how many types the process uses
+	REQUIRE(smallDomain.memoryReport().structures.at("signatureRows").usedBytes == 10 * sizeof(uint64_t));
+
+	// Removing a component type which the Domain has never used does nothing
+	smallDomain.createEntity()->removeComponent<ComponentF>();
+	smallDomain.clean();
+	REQUIRE(smallDomain.getNumComponentTypes() == 2);
+	REQUIRE(smallDomain.getNumEntities() == 11);
+
+	int entityCount = 0;
+	smallDomain.forMatchingEntities<ComponentB, ComponentD>([&entityCount](auto entity, auto b, auto d) {
+		REQUIRE(b != nullptr);
+		REQUIRE(d != nullptr);
+		entityCount++;
+		});
+	REQUIRE(entityCount == 5);
+
+	entityCount = 0;
+	smallDomain.forMatchingEntities<ComponentD, ComponentE>([&entityCount](auto entity, auto d, auto e) {
+		entityCount++;
+		});
+	REQUIRE(entityCount == 0);
+	REQUIRE(smallDomain.getNumComponentTypes() == 2);
+
+	entityCount = 0;
+	bigDomain.forMatchingEntities<ComponentB, ComponentD, ComponentE>([&entityCount, bigEntity](auto entity, auto b, auto d, auto e) {
+		REQUIRE(entity == bigEntity);
+		entityCount++;
+		});
+	REQUIRE(entityCount == 1);
+
+	// Removing and adding components of the Domain's types
+	smallDomain.forEachEntity([](River::ECS::Entity* entity) {
+		entity->removeComponent<ComponentD>();
+		});
+	smallDomain.clean();
+
+	entityCount = 0;
+	smallDomain.forMatchingEntities<ComponentD>([&entityCount](auto entity, auto d) {
+		entityCount++;
+		});
+	REQUIRE(entityCount == 0);
+
+	entityCount = 0;
+	smallDomain.forMatchingEntities<ComponentB>([&entityCount](auto entity, auto b) {
+		entityCount++;
+		});
+	REQUIRE(entityCount == 5);
+}
+
+
+
+
 // ==============================================================================================================================================================================================
 TEST_CASE("Same Cycle Create and Destroy", "[entity]") {
 	/*	Checking that Entities and Components are handled correctly
@@ -314,8 +497,12 @@ TEST_CASE("Same Cycle Create and Destroy", "[entity]") {
 
 		domain.clean();
 
-		REQUIRE(domain.getEntityComponent<ComponentA>(entity3) == nullptr);
-		REQUIRE(domain.getEntityComponent<ComponentD>(entity3) == nullptr);
+		// entity3 is deleted by the clean, so its components are checked through the queries
+		entityCount = 0;
+		domain.forMatchingEntities<ComponentA>([&entityCount](auto entity, auto a) {
+			entityCount++;
+		});
+		REQUIRE(entityCount == 2);
 
 		entityCount = 0;
 		domain.forMatchingEntities<ComponentD>([&entityCount](auto entity, auto a) {
@@ -367,8 +554,12 @@ TEST_CASE("Same Cycle Create and Destroy", "[entity]") {
 
 		domain.clean();
 
-		REQUIRE(domain.getEntityComponent<ComponentA>(entity3) == nullptr);
-		REQUIRE(domain.getEntityComponent<ComponentD>(entity3) == nullptr);
+		// entity3 is deleted by the clean, so its components are checked through the queries
+		entityCount = 0;
+		domain.forMatchingEntities<ComponentA>([&entityCount](auto entity, auto a) {
+			entityCount++;
+		});
+		REQUIRE(entityCount == 2);
 
 		entityCount = 0;
 		domain.forMatchingEntities<ComponentD>([&entityCount](auto entity, auto a) {
@@ -409,8 +600,12 @@ TEST_CASE("Same Cycle Create and Destroy", "[entity]") {
 		domain.destroyEntity(entity4);
 		domain.clean();
 
-		REQUIRE(domain.getEntityComponent<ComponentA>(entity4) == nullptr);
-		REQUIRE(domain.getEntityComponent<ComponentD>(entity4) == nullptr);
+		// entity4 is deleted by the clean, so its components are checked through the queries
+		entityCount = 0;
+		domain.forMatchingEntities<ComponentA>([&entityCount](auto entity, auto a) {
+			entityCount++;
+		});
+		REQUIRE(entityCount == 3);
 
 		entityCount = 0;
 		domain.forMatchingEntities<ComponentD>([&entityCount](auto entity, auto d) {
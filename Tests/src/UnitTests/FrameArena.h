@@ -0,0 +1,99 @@
+#pragma once
+
+#include <catch.h>
+
+#include <ECS.h>
+#include <ECS/FrameArena.h>
+
+#include "MemoryResource.h"
+#include "TestComponents.h"
+#include "Log.h"
+
+
+
+TEST_CASE("Frame arena", "[memory_resource]") {
+
+	CountingMemoryResource resource;
+
+	{
+		River::ECS::FrameArena arena(1024, &resource);
+		REQUIRE(arena.getCapacity() == 1024);
+		REQUIRE(resource.numAllocations == 1);
+
+		SECTION("Allocations fit in block") {
+			for( int i = 0; i < 10; i++ ) {
+				void* memory = arena.allocate(64, 16);
+				REQUIRE(((uintptr_t)memory % 16) == 0);
+			}
+			REQUIRE(resource.numAllocations == 1);
+			REQUIRE(arena.getBytesAllocated() >= 640);
+
+			arena.reset();
+			REQUIRE(arena.getBytesAllocated() == 0);
+			REQUIRE(arena.getCapacity() == 1024);
+			REQUIRE(resource.numAllocations == 1);
+		}
+
+		SECTION("Allocations are aligned beyond the block's alignment") {
+			for( int i = 0; i < 10; i++ ) {
+				(void)arena.allocate(8, 1);
+				void* memory = arena.allocate(64, 64);
+				REQUIRE(((uintptr_t)memory % 64) == 0);
+			}
+		}
+
+		SECTION("Block grows to fit overflowing frame") {
+			for( int i = 0; i < 100; i++ )
+				(void)arena.allocate(64);
+			REQUIRE(resource.numAllocations > 1);
+
+			arena.reset();
+			REQUIRE(arena.getCapacity() >= 6400);
+
+			// The same frame again doesn't allocate from upstream
+			unsigned int numAllocations = resource.numAllocations;
+			for( int i = 0; i < 100; i++ )
+				(void)arena.allocate(64);
+			arena.reset();
+			REQUIRE(resource.numAllocations == numAllocations);
+		}
+	}
+
+	REQUIRE(resource.bytesInUse == 0);
+}
+
+
+
+TEST_CASE("Cleaning doesn't grow frame memory in steady state", "[memory_resource]") {
+
+	CountingMemoryResource resource;
+
+	River::ECS::DomainSettings settings;
+	settings.memoryResource = &resource;
+	settings.frameArenaSize = 256;
+
+	River::ECS::Domain domain(settings);
+
+	// Each frame creates, modifies and destroys the same number of entities
+	std::vector<River::ECS::Entity*> entities;
+	auto runFrame = [&]() {
+		for( auto entity : entities )
+			entity->destroy();
+		entities.clear();
+		for( int i = 0; i < 500; i++ ) {
+			auto entity = domain.createEntity();
+			entity->addComponent<ComponentA>();
+			entity->addComponent<ComponentB>();
+			entities.push_back(entity);
+		}
+		domain.clean();
+	};
+
+	for( int i = 0; i < 3; i++ )
+		runFrame();
+	size_t bytesInUse = resource.bytesInUse;
+
+	for( int i = 0; i < 10; i++ )
+		runFrame();
+	REQUIRE(resource.bytesInUse == bytesInUse);
+}
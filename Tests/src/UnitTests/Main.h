@@ -12,7 +12,20 @@
 #include "Signature/Signature.h"
 #include "Signature/SignatureArray.h"
 #include "ComponentController.h"
+#include "ComponentTypeRegistry.h"
+#include "ComponentRef.h"
+#include "View.h"
+#include "ComponentFields.h"
 #include "Entity.h"
+#include "Replication.h"
+#include "DomainSnapshot.h"
+#include "ChangeTracker.h"
+#include "StaticDomain.h"
+#include "MemoryResource.h"
+#include "FrameArena.h"
+#include "Statistics.h"
+#include "Tracing.h"
+#include "MemoryReport.h"
 //#include "General.h"
 // -----------------------------------------------------
 
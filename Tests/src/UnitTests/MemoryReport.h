@@ -0,0 +1,68 @@
+#pragma once
+
+#include <catch.h>
+
+#include <ECS.h>
+#include <ECS/MemoryReport.h>
+
+#include "TestComponents.h"
+#include "Log.h"
+
+
+
+TEST_CASE("Memory report", "[memory_report]") {
+
+	River::ECS::Domain domain;
+	auto componentTypeId = River::ECS::ComponentTypeRegistry::getTypeId<ComponentA>();
+
+	std::vector<River::ECS::Entity*> entities;
+	for( int i = 0; i < 1000; i++ ) {
+		auto entity = domain.createEntity();
+		entity->addComponent<ComponentA>();
+		entities.push_back(entity);
+	}
+
+	SECTION("New components") {
+		auto report = domain.memoryReport();
+		auto& componentType = report.componentTypes.at(componentTypeId);
+		REQUIRE(componentType.name.find("ComponentA") != std::string::npos);
+		REQUIRE(componentType.structures.at("components").usedBytes == 0);
+		REQUIRE(componentType.structures.at("newComponents").usedBytes == 1000 * sizeof(ComponentA));
+		REQUIRE(report.structures.at("entityObjects").usedBytes == 1000 * sizeof(River::ECS::Entity));
+		REQUIRE(report.structures.at("frameArena").usedBytes > 0);
+	}
+
+	domain.clean();
+
+	SECTION("Cleaned components") {
+		auto report = domain.memoryReport();
+		auto& componentType = report.componentTypes.at(componentTypeId);
+		REQUIRE(componentType.structures.at("components").usedBytes == 1000 * sizeof(ComponentA));
+		REQUIRE(componentType.structures.at("components").reservedBytes >= 1000 * sizeof(ComponentA));
+		REQUIRE(componentType.structures.at("newComponents").usedBytes == 0);
+		REQUIRE(componentType.structures.at("entityIndices").usedBytes == 1000 * sizeof(unsigned int));
+		REQUIRE(componentType.structures.at("componentEntities").usedBytes == 1000 * sizeof(River::ECS::Entity*));
+		REQUIRE(report.structures.at("entities").usedBytes == 1000 * sizeof(River::ECS::Entity*));
+		REQUIRE(report.structures.at("signatureColumns").usedBytes > 0);
+		REQUIRE(report.structures.at("frameArena").usedBytes == 0);
+
+		auto total = report.getTotal();
+		REQUIRE(total.usedBytes <= total.reservedBytes);
+		REQUIRE(total.usedBytes >= componentType.getTotal().usedBytes + report.structures.at("entities").usedBytes);
+
+		auto json = report.toJson();
+		REQUIRE(json.find("{\"total\":{\"usedBytes\":" + std::to_string(total.usedBytes)) == 0);
+		REQUIRE(json.find("\"components\":{\"usedBytes\":" + std::to_string(1000 * sizeof(ComponentA))) != std::string::npos);
+	}
+
+	SECTION("Destroyed entities") {
+		for( int i = 0; i < 500; i++ )
+			entities[i]->destroy();
+		domain.clean();
+
+		auto report = domain.memoryReport();
+		auto& componentType = report.componentTypes.at(componentTypeId);
+		REQUIRE(componentType.structures.at("components").usedBytes == 500 * sizeof(ComponentA));
+		REQUIRE(report.structures.at("entities").usedBytes == 500 * sizeof(River::ECS::Entity*));
+	}
+}
@@ -0,0 +1,86 @@
+#pragma once
+
+#include <catch.h>
+#include <memory_resource>
+
+#include <ECS.h>
+
+#include "TestComponents.h"
+#include "Log.h"
+
+
+// Memory resource which keeps track of the memory allocated through it
+class CountingMemoryResource : public std::pmr::memory_resource {
+public:
+	size_t bytesInUse = 0;
+	unsigned int numAllocations = 0;
+
+private:
+	void* do_allocate(size_t bytes, size_t alignment) override {
+		bytesInUse += bytes;
+		numAllocations++;
+		return std::pmr::new_delete_resource()->allocate(bytes, alignment);
+	}
+
+	void do_deallocate(void* p, size_t bytes, size_t alignment) override {
+		bytesInUse -= bytes;
+		std::pmr::new_delete_resource()->deallocate(p, bytes, alignment);
+	}
+
+	bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override {
+		return this == &other;
+	}
+};
+
+
+
+TEST_CASE("Domain allocates from memory resource", "[memory_resource]") {
+
+	CountingMemoryResource resource;
+
+	River::ECS::DomainSettings settings;
+	settings.memoryResource = &resource;
+
+	SECTION("Without arena") {
+		settings.useArena = false;
+	}
+
+	SECTION("With arena") {
+		settings.useArena = true;
+	}
+
+	{
+		River::ECS::Domain domain(settings);
+		REQUIRE(resource.bytesInUse > 0); // Initial signature memory
+
+		std::vector<River::ECS::Entity*> entities;
+		for( int i = 0; i < 1000; i++ ) {
+			auto entity = domain.createEntity();
+			entity->addComponent<ComponentA>()->a = i;
+			if( i % 3 == 0 )
+				entity->addComponent<ComponentB>();
+			entities.push_back(entity);
+		}
+		domain.clean();
+
+		for( int i = 0; i < 1000; i += 2 )
+			entities[i]->destroy();
+		domain.clean();
+
+		int count = 0;
+		domain.forMatchingEntities<ComponentA, ComponentB>([&count](auto entity, auto a, auto b) {
+			count++;
+		});
+		REQUIRE(count == 167);
+
+		if( settings.useArena ) {
+			// The arena allocates in large chunks
+			REQUIRE(resource.numAllocations < 100);
+		} else {
+			REQUIRE(resource.numAllocations > 1000);
+		}
+	}
+
+	// All memory is returned when the Domain is destroyed
+	REQUIRE(resource.bytesInUse == 0);
+}
@@ -0,0 +1,303 @@
+#pragma once
+
+#include <catch.h>
+
+#include <ECS.h>
+#include <ECS/Replication/DeltaEncoder.h>
+#include <ECS/Replication/DeltaDecoder.h>
+#include <ECS/DomainSnapshot.h>
+
+#include "TestComponents.h"
+#include "Log.h"
+
+
+struct ReplicatedPosition : public River::ECS::Component {
+	float x = 0, y = 0, z = 0;
+};
+
+struct ReplicatedHealth : public River::ECS::Component {
+	int health = 100;
+	int maxHealth = 100;
+	char padding[64] = { 0 };
+};
+
+struct ReplicatedUnit : public River::ECS::Component {
+	char team = 0;
+	double speed = 0;
+};
+
+RV_ECS_REPLICATED_FIELDS(ReplicatedUnit, &ReplicatedUnit::team, &ReplicatedUnit::speed);
+
+
+// Checks that the client's entities match the server's
+void checkReplicatedDomain(River::ECS::Domain& server, River::ECS::DeltaDecoder& decoder, River::ECS::Domain& client) {
+	REQUIRE(server.getNumEntities() == client.getNumEntities());
+
+	server.forEachEntity([&decoder](River::ECS::Entity* serverEntity) {
+		auto clientEntity = decoder.getEntity(serverEntity->getId());
+		REQUIRE(clientEntity != nullptr);
+
+		auto serverPosition = serverEntity->getComponent<ReplicatedPosition>();
+		auto clientPosition = clientEntity->getComponent<ReplicatedPosition>();
+		REQUIRE((serverPosition == nullptr) == (clientPosition == nullptr));
+		if( serverPosition != nullptr ) {
+			REQUIRE(serverPosition->x == clientPosition->x);
+			REQUIRE(serverPosition->y == clientPosition->y);
+			REQUIRE(serverPosition->z == clientPosition->z);
+		}
+
+		auto serverHealth = serverEntity->getComponent<ReplicatedHealth>();
+		auto clientHealth = clientEntity->getComponent<ReplicatedHealth>();
+		REQUIRE((serverHealth == nullptr) == (clientHealth == nullptr));
+		if( serverHealth != nullptr ) {
+			REQUIRE(serverHealth->health == clientHealth->health);
+			REQUIRE(serverHealth->maxHealth == clientHealth->maxHealth);
+		}
+	});
+}
+
+
+
+TEST_CASE("Delta encoding and decoding", "[replication]") {
+
+	River::ECS::Domain server;
+	River::ECS::Domain client;
+
+	River::ECS::DeltaEncoder encoder;
+	encoder.addComponentType<ReplicatedPosition>();
+	encoder.addComponentType<ReplicatedHealth>();
+
+	River::ECS::DeltaDecoder decoder;
+	decoder.addComponentType<ReplicatedPosition>();
+	decoder.addComponentType<ReplicatedHealth>();
+
+	std::vector<River::ECS::Entity*> entities;
+	for( int i = 0; i < 100; i++ ) {
+		auto entity = server.createEntity();
+		entity->addComponent<ReplicatedPosition>()->x = (float)i;
+		if( i % 2 == 0 )
+			entity->addComponent<ReplicatedHealth>()->health = i;
+		entities.push_back(entity);
+	}
+	server.clean();
+
+	// Full state
+	auto fullDelta = encoder.encode(server, 1);
+	decoder.decode(client, fullDelta);
+	client.clean();
+	checkReplicatedDomain(server, decoder, client);
+	encoder.acknowledge(1);
+
+
+	SECTION("Unchanged state") {
+		auto delta = encoder.encode(server, 2, 1);
+		REQUIRE(delta.size() < 10);
+		decoder.decode(client, delta);
+		client.clean();
+		checkReplicatedDomain(server, decoder, client);
+	}
+
+
+	SECTION("Changed component data") {
+		entities[10]->getComponent<ReplicatedPosition>()->y = 5.0f;
+		entities[10]->markChanged();
+		entities[20]->getComponent<ReplicatedHealth>()->health = 1;
+		entities[20]->markChanged();
+
+		auto delta = encoder.encode(server, 2, 1);
+		REQUIRE(delta.size() < fullDelta.size() / 10);
+
+		decoder.decode(client, delta);
+		client.clean();
+		checkReplicatedDomain(server, decoder, client);
+	}
+
+
+	SECTION("Created and destroyed entities, added and removed components") {
+		auto destroyedId = entities[5]->getId();
+		entities[5]->destroy();
+		entities[6]->removeComponent<ReplicatedPosition>();
+		entities[7]->addComponent<ReplicatedHealth>()->maxHealth = 50;
+		server.createEntity()->addComponent<ReplicatedPosition>()->z = 3.0f;
+		server.createEntity();
+		server.clean();
+
+		decoder.decode(client, encoder.encode(server, 2, 1));
+		client.clean();
+		checkReplicatedDomain(server, decoder, client);
+		REQUIRE(decoder.getEntity(destroyedId) == nullptr);
+	}
+
+
+	SECTION("Skipped delta") {
+		// Tick 2 is lost, so tick 3 is still encoded against tick 1
+		entities[1]->getComponent<ReplicatedPosition>()->x = 99.0f;
+		entities[1]->markChanged();
+		entities[2]->destroy();
+		server.clean();
+		auto lostDelta = encoder.encode(server, 2, 1);
+
+		entities[3]->getComponent<ReplicatedPosition>()->x = 99.0f;
+		entities[3]->markChanged();
+		server.createEntity()->addComponent<ReplicatedHealth>();
+		server.clean();
+		decoder.decode(client, encoder.encode(server, 3, 1));
+		client.clean();
+		checkReplicatedDomain(server, decoder, client);
+
+		// Tick 2 arrives late, and is ignored
+		decoder.decode(client, lostDelta);
+		REQUIRE(decoder.getTick() == 3);
+		checkReplicatedDomain(server, decoder, client);
+	}
+
+
+	SECTION("Unmarked writes") {
+		entities[10]->getComponent<ReplicatedPosition>()->y = 5.0f;
+		REQUIRE(encoder.encode(server, 2, 1).size() < 10);
+
+		entities[10]->markChanged();
+		decoder.decode(client, encoder.encode(server, 3, 1));
+		client.clean();
+		checkReplicatedDomain(server, decoder, client);
+	}
+
+
+	SECTION("Changes since an older baseline") {
+		// Tick 2 is applied, but not acknowledged
+		entities[1]->getComponent<ReplicatedPosition>()->x = 99.0f;
+		entities[1]->markChanged();
+		auto temporaryEntity = server.createEntity();
+		temporaryEntity->addComponent<ReplicatedPosition>();
+		server.clean();
+		decoder.decode(client, encoder.encode(server, 2, 1));
+		client.clean();
+
+		// Tick 3 reverts the changes of tick 2, so tick 3 equals tick 1 and the client must undo tick 2
+		entities[1]->getComponent<ReplicatedPosition>()->x = 1.0f;
+		entities[1]->markChanged();
+		auto temporaryId = temporaryEntity->getId();
+		temporaryEntity->destroy();
+		server.clean();
+		auto delta = encoder.encode(server, 3, 1);
+		REQUIRE(delta.size() < 10);
+
+		decoder.decode(client, delta);
+		client.clean();
+		checkReplicatedDomain(server, decoder, client);
+		REQUIRE(decoder.getEntity(temporaryId) == nullptr);
+	}
+
+
+	SECTION("Restored Domain") {
+		River::ECS::DomainSnapshot snapshot(server);
+		server.snapshot(snapshot);
+		decoder.decode(client, encoder.encode(server, 2, 1));
+		client.clean();
+
+		// Changes which are undone by the restore don't have to be marked
+		entities[1]->getComponent<ReplicatedPosition>()->x = 99.0f;
+		entities[2]->destroy();
+		server.createEntity()->addComponent<ReplicatedPosition>();
+		server.clean();
+		decoder.decode(client, encoder.encode(server, 3, 2));
+		client.clean();
+
+		server.restore(snapshot);
+		decoder.decode(client, encoder.encode(server, 4, 3));
+		client.clean();
+		checkReplicatedDomain(server, decoder, client);
+	}
+
+
+	SECTION("Decoding into an uncleaned Domain") {
+		entities[7]->addComponent<ReplicatedHealth>();
+		server.clean();
+		decoder.decode(client, encoder.encode(server, 2, 1));
+
+		entities[8]->getComponent<ReplicatedPosition>()->x = 99.0f;
+		entities[8]->markChanged();
+		REQUIRE_THROWS_AS(decoder.decode(client, encoder.encode(server, 3, 1)), River::ECS::DomainNotCleanException);
+		REQUIRE(decoder.getTick() == 2);
+	}
+
+
+	SECTION("Missing baseline") {
+		auto delta = encoder.encode(server, 3, 2);
+		REQUIRE_NOTHROW(decoder.decode(client, delta)); // Tick 2 was never encoded, so the full state is sent
+
+		encoder.acknowledge(3);
+		REQUIRE(encoder.getNumSnapshots() == 1);
+	}
+}
+
+
+
+TEST_CASE("Replicating listed fields", "[replication]") {
+
+	River::ECS::ReplicatedType<ReplicatedUnit> type;
+	REQUIRE(type.getDataSize() == sizeof(char) + sizeof(double));
+
+	River::ECS::Domain server;
+	River::ECS::Domain client;
+
+	River::ECS::DeltaEncoder encoder;
+	encoder.addComponentType<ReplicatedUnit>();
+	River::ECS::DeltaDecoder decoder;
+	decoder.addComponentType<ReplicatedUnit>();
+
+	auto entity = server.createEntity();
+	auto unit = entity->addComponent<ReplicatedUnit>();
+	unit->team = 2;
+	unit->speed = 1.5;
+	server.clean();
+
+	decoder.decode(client, encoder.encode(server, 1));
+	client.clean();
+	encoder.acknowledge(1);
+
+	// Padding between the fields isn't replicated, so garbage in it isn't a change
+	unit = entity->getComponent<ReplicatedUnit>();
+	for( unsigned char* padding = (unsigned char*)&unit->team + 1; padding < (unsigned char*)&unit->speed; padding++ )
+		*padding = 0xAB;
+	entity->markChanged();
+	REQUIRE(encoder.encode(server, 2, 1).size() < 10);
+
+	unit->speed = 3.0;
+	entity->markChanged();
+	decoder.decode(client, encoder.encode(server, 3, 1));
+	client.clean();
+
+	auto clientUnit = decoder.getEntity(entity->getId())->getComponent<ReplicatedUnit>();
+	REQUIRE(clientUnit->team == 2);
+	REQUIRE(clientUnit->speed == 3.0);
+}
+
+
+
+TEST_CASE("Replicating component types which the Domain doesn't use", "[replication]") {
+
+	River::ECS::Domain server;
+	River::ECS::Domain client;
+
+	River::ECS::DeltaEncoder encoder;
+	encoder.addComponentType<ReplicatedPosition>();
+	encoder.addComponentType<ReplicatedHealth>();
+	River::ECS::DeltaDecoder decoder;
+	decoder.addComponentType<ReplicatedPosition>();
+	decoder.addComponentType<ReplicatedHealth>();
+
+	for( int i = 0; i < 10; i++ )
+		server.createEntity()->addComponent<ReplicatedPosition>()->x = (float)i;
+	server.clean();
+
+	decoder.decode(client, encoder.encode(server, 1));
+	client.clean();
+
+	// Neither encoding nor decoding gives the Domains a signature bit for the health type
+	REQUIRE(server.getNumComponentTypes() == 1);
+	REQUIRE(!server.usesComponentType<ReplicatedHealth>());
+	REQUIRE(client.getNumComponentTypes() == 1);
+
+	checkReplicatedDomain(server, decoder, client);
+}
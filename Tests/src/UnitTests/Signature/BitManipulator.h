@@ -2,6 +2,7 @@
 
 #include <catch.h>
 #include <unordered_set>
+#include <set>
 
 #include <ECS/SignatureArray/BitManipulator.h>
 
@@ -89,4 +90,105 @@ TEST_CASE("Generel tests", "[bit_manipulator]") {
 
 
 	delete[] data;
-}
\ No newline at end of file
+}
+
+
+TEST_CASE("Bits across word boundaries", "[bit_manipulator]") {
+	// Not a multiple of the word size, so the last word is partial
+	unsigned int bytes = 21;
+	unsigned int bits = bytes * 8;
+	unsigned char* data = new unsigned char[bytes]();
+	River::ECS::BitManipulator manipulator(data, bits);
+
+	unsigned int expectedBits[] = {
+		0, 62, 63, 64, 65, 127, 128, 150, 167
+	};
+
+	for( auto& bit : expectedBits )
+		manipulator.setUnchecked(bit);
+
+	REQUIRE(manipulator.getBitsSet() == 9);
+	REQUIRE(manipulator.getFirstSetBit() == 0);
+	REQUIRE(manipulator.getLastSetBit() == 167);
+
+	std::vector<unsigned int> bitsCallbacked;
+	manipulator.forEachSetBit([&bitsCallbacked](unsigned int bitIndex) {
+		bitsCallbacked.push_back(bitIndex);
+	});
+	REQUIRE(bitsCallbacked == std::vector<unsigned int>(std::begin(expectedBits), std::end(expectedBits)));
+
+	manipulator.unsetUnchecked(0);
+	manipulator.unsetUnchecked(167);
+	REQUIRE_FALSE(manipulator.getUnchecked(0));
+	REQUIRE(manipulator.getUnchecked(62));
+	REQUIRE(manipulator.getBitsSet() == 7);
+	REQUIRE(manipulator.getFirstSetBit() == 62);
+	REQUIRE(manipulator.getLastSetBit() == 150);
+
+	REQUIRE_THROWS_AS(manipulator.set(bits), std::out_of_range);
+
+	delete[] data;
+}
+
+
+
+TEST_CASE("First, last and count are kept up to date", "[bit_manipulator]") {
+	// Large enough for the word summary to be heap allocated
+	unsigned int bytes = 2000;
+	unsigned int bits = bytes * 8;
+	unsigned char* data = new unsigned char[bytes]();
+	River::ECS::BitManipulator manipulator(data, bits);
+
+	std::set<unsigned int> expected;
+	srand(1234);
+	for( int i = 0; i < 5000; i++ ) {
+		unsigned int bit = rand() % bits;
+		int operation = rand() % 3;
+
+		if( operation == 0 ) {
+			manipulator.set(bit);
+			expected.insert(bit);
+		} else if( operation == 1 ) {
+			manipulator.unset(bit);
+			expected.erase(bit);
+		} else {
+			// Unset the first or last bit, which must be searched for
+			if( expected.empty() ) continue;
+			unsigned int setBit = rand() % 2 == 0 ? *expected.begin() : *expected.rbegin();
+			manipulator.unset(setBit);
+			expected.erase(setBit);
+		}
+
+		REQUIRE(manipulator.getBitsSet() == expected.size());
+		REQUIRE(manipulator.getFirstSetBit() == (expected.empty() ? -1 : (int)*expected.begin()));
+		REQUIRE(manipulator.getLastSetBit() == (expected.empty() ? -1 : (int)*expected.rbegin()));
+	}
+
+	SECTION("Overwriting parts") {
+		for( unsigned int part = 0; part < bytes; part += 3 ) {
+			manipulator.setPart(part, 0x81);
+			for( unsigned int bit = part * 8; bit < part * 8 + 8; bit++ )
+				expected.erase(bit);
+			expected.insert(part * 8);
+			expected.insert(part * 8 + 7);
+		}
+		REQUIRE(manipulator.getBitsSet() == expected.size());
+		REQUIRE(manipulator.getFirstSetBit() == (int)*expected.begin());
+		REQUIRE(manipulator.getLastSetBit() == (int)*expected.rbegin());
+	}
+
+	SECTION("Same result as scanning the data") {
+		River::ECS::BitManipulator scanned(data, bits);
+		REQUIRE(scanned.getBitsSet() == manipulator.getBitsSet());
+		REQUIRE(scanned.getFirstSetBit() == manipulator.getFirstSetBit());
+		REQUIRE(scanned.getLastSetBit() == manipulator.getLastSetBit());
+
+		std::vector<unsigned int> bitsCallbacked;
+		scanned.forEachSetBit([&bitsCallbacked](unsigned int bitIndex) {
+			bitsCallbacked.push_back(bitIndex);
+		});
+		REQUIRE(bitsCallbacked == std::vector<unsigned int>(expected.begin(), expected.end()));
+	}
+
+	delete[] data;
+}
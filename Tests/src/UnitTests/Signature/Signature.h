@@ -57,4 +57,41 @@ TEST_CASE("Resizing Signature", "[signature]") {
 	REQUIRE(signature.getBitsSet() == 13);
 	REQUIRE(signature.getLastSetBit() == 65);
 
-}
\ No newline at end of file
+}
+
+
+TEST_CASE("Copying and moving Signature", "[signature]") {
+
+	// Both within and beyond the inline storage
+	unsigned int size = GENERATE(40, River::ECS::Signature::INLINE_BITS, River::ECS::Signature::INLINE_BITS + 100);
+
+	River::ECS::Signature signature(size);
+	signature.set(3);
+	signature.set(size - 1);
+
+	River::ECS::Signature copy(signature);
+	REQUIRE(copy == signature);
+	REQUIRE(copy.getBits() != signature.getBits());
+
+	copy.unset(3);
+	REQUIRE(copy != signature);
+	REQUIRE(signature.get(3));
+
+	copy = signature;
+	REQUIRE(copy == signature);
+
+	River::ECS::Signature moved(std::move(copy));
+	REQUIRE(moved == signature);
+	REQUIRE(moved.getBitsSet() == 2);
+	REQUIRE(moved.getLastSetBit() == (int)size - 1);
+
+	River::ECS::Signature assigned(10);
+	assigned = std::move(moved);
+	REQUIRE(assigned == signature);
+
+	// Growing beyond the inline storage keeps the bits
+	assigned.resize(size + River::ECS::Signature::INLINE_BITS);
+	REQUIRE(assigned.getBitsSet() == 2);
+	REQUIRE(assigned.get(size - 1));
+	REQUIRE_FALSE(assigned.get(size));
+}
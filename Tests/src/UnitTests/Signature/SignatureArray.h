@@ -270,3 +270,199 @@ TEST_CASE("Testing reallocation of array", "[signature_array]") {
 
 
 
+
+
+
+TEST_CASE("Matching sparse signatures", "[signature_array]") {
+	auto layout = GENERATE(River::ECS::SignatureLayout::RowMajor, River::ECS::SignatureLayout::ColumnMajor);
+	River::ECS::SignatureArray signatureArray(1000, std::pmr::get_default_resource(), layout);
+	unsigned int signatureSize = 10;
+	signatureArray.setSignatureSize(signatureSize);
+
+	// Bit 0 is set in all signatures, bit 3 in a few, and bit 5 in every other
+	unsigned int numSignatures = 10000;
+	for( unsigned int i = 0; i < numSignatures; i++ ) {
+		auto signatureIndex = signatureArray.add();
+		signatureArray.setSignatureBit(signatureIndex, 0);
+		if( i % 97 == 0 )
+			signatureArray.setSignatureBit(signatureIndex, 3);
+		if( i % 2 == 0 )
+			signatureArray.setSignatureBit(signatureIndex, 5);
+	}
+
+	SECTION("Removing and unsetting bits") {
+		signatureArray.remove(0);
+		signatureArray.remove(97);
+		signatureArray.remove(signatureArray.getNumSignatures() - 1);
+		signatureArray.unsetSignatureBit(194, 3);
+		signatureArray.setSignatureBit(195, 3);
+	}
+
+	SECTION("Growing signature size") {
+		signatureSize = 100;
+		signatureArray.setSignatureSize(signatureSize);
+		signatureArray.setSignatureBit(5000, 80);
+	}
+
+	SECTION("Copied array") {
+		River::ECS::SignatureArray copy(10);
+		copy.copyFrom(signatureArray);
+		signatureArray.clear();
+		signatureArray.copyFrom(copy);
+	}
+
+	for( auto& bits : std::vector<std::vector<unsigned int>>{ { 3 }, { 3, 5 }, { 0, 5 }, { 80 } } ) {
+		River::ECS::Signature signature(100);
+		for( auto bit : bits )
+			signature.set(bit);
+
+		// Matches found by checking each signature
+		std::vector<unsigned int> expected;
+		for( unsigned int i = 0; i < signatureArray.getNumSignatures(); i++ ) {
+			bool match = true;
+			for( auto bit : bits )
+				match = match && bit < signatureSize && signatureArray.getSignatureBit(i, bit);
+			if( match ) expected.push_back(i);
+		}
+
+		// The set bits of a signature are the ones found by checking each bit
+		std::vector<unsigned int> setBits, expectedBits;
+		signatureArray.forEachSetBit(195, [&setBits](unsigned int bitIndex) { setBits.push_back(bitIndex); });
+		for( unsigned int bit = 0; bit < signatureSize; bit++ ) {
+			if( signatureArray.getSignatureBit(195, bit) ) expectedBits.push_back(bit);
+		}
+		REQUIRE(setBits == expectedBits);
+
+		std::vector<unsigned int> matches;
+		signatureArray.forMatchingSignatures(signature, [&matches](unsigned int signatureIndex) {
+			matches.push_back(signatureIndex);
+		});
+		REQUIRE(matches == expected);
+	}
+}
+
+
+
+TEST_CASE("Growing signature capacity", "[signature_array]") {
+	River::ECS::SignatureArray signatureArray(100);
+	signatureArray.reserveSignatureSize(128);
+	REQUIRE(signatureArray.getSignatureCapacity() == 128);
+
+	signatureArray.setSignatureSize(10);
+	for( unsigned int i = 0; i < 100; i++ ) {
+		auto signatureIndex = signatureArray.add();
+		signatureArray.setSignatureBit(signatureIndex, i % 10);
+	}
+	unsigned int memorySize = signatureArray.getMemorySize();
+
+	// Within the reserved capacity, signatures aren't moved
+	signatureArray.setSignatureSize(128);
+	REQUIRE(signatureArray.getSignatureCapacity() == 128);
+	REQUIRE(signatureArray.getMemorySize() == memorySize);
+	signatureArray.setSignatureBit(50, 127);
+
+	// Beyond it, the capacity is doubled
+	signatureArray.setSignatureSize(130);
+	REQUIRE(signatureArray.getSignatureCapacity() == 256);
+	signatureArray.setSignatureBit(51, 129);
+
+	for( unsigned int i = 0; i < 100; i++ ) {
+		for( unsigned int bit = 0; bit < 130; bit++ ) {
+			bool expected = bit == i % 10 || (i == 50 && bit == 127) || (i == 51 && bit == 129);
+			REQUIRE(signatureArray.getSignatureBit(i, bit) == expected);
+		}
+	}
+
+	// Removing uses the moved rows to move the last signature's bits
+	signatureArray.remove(51);
+	REQUIRE(signatureArray.getSignatureBit(51, 9));
+	REQUIRE_FALSE(signatureArray.getSignatureBit(51, 129));
+	signatureArray.remove(0);
+	REQUIRE(signatureArray.getSignatureBit(0, 8));
+	REQUIRE(signatureArray.getSignatureBit(50, 127));
+}
+
+
+
+TEST_CASE("Copying signatures keeps the reserved memory", "[signature_array]") {
+	River::ECS::SignatureArray signatureArray(100, std::pmr::get_default_resource(), River::ECS::SignatureLayout::ColumnMajor);
+	signatureArray.setSignatureSize(10);
+	signatureArray.reserveSignatures(20000);
+	for( unsigned int i = 0; i < 100; i++ )
+		signatureArray.setSignatureBit(signatureArray.add(), i % 10);
+
+	River::ECS::SignatureArray copy(100);
+	copy.copyFrom(signatureArray);
+	unsigned int numGrowths = copy.getNumGrowths();
+	for( unsigned int i = 0; i < 10000; i++ )
+		copy.setSignatureBit(copy.add(), i % 10);
+	REQUIRE(copy.getNumGrowths() == numGrowths);
+	REQUIRE(copy.getSignatureBit(10099, 9));
+}
+
+
+
+TEST_CASE("Copied rows are used as they are", "[signature_array]") {
+	River::ECS::SignatureArray signatureArray(100);
+	signatureArray.setSignatureSize(70);
+	for( unsigned int i = 0; i < 1000; i++ ) {
+		auto signatureIndex = signatureArray.add();
+		signatureArray.setSignatureBit(signatureIndex, i % 70);
+		signatureArray.setSignatureBit(signatureIndex, 69);
+	}
+
+	// The copy's rows are read by forEachSetBit() and remove(), without being scanned when copied
+	River::ECS::SignatureArray copy(100);
+	copy.copyFrom(signatureArray);
+	copy.remove(5);
+	std::vector<unsigned int> bits;
+	copy.forEachSetBit(5, [&bits](unsigned int bitIndex) { bits.push_back(bitIndex); });
+	REQUIRE(bits == std::vector<unsigned int>{ 999 % 70, 69 });
+
+	River::ECS::Signature query(70);
+	query.set(5);
+	unsigned int numMatches = 0;
+	copy.forMatchingSignatures(query, [&numMatches](unsigned int) { numMatches++; });
+	REQUIRE(numMatches == 14);
+}
+
+
+
+TEST_CASE("Growing and shrinking signature memory", "[signature_array]") {
+	auto layout = GENERATE(River::ECS::SignatureLayout::RowMajor, River::ECS::SignatureLayout::ColumnMajor);
+	River::ECS::SignatureArray signatureArray(100, std::pmr::get_default_resource(), layout);
+	signatureArray.setSignatureSize(10);
+
+	// Memory grows geometrically, so it's only reallocated a few times
+	unsigned int numSignatures = 100000;
+	for( unsigned int i = 0; i < numSignatures; i++ ) {
+		auto signatureIndex = signatureArray.add();
+		signatureArray.setSignatureBit(signatureIndex, i % 10);
+	}
+	REQUIRE(signatureArray.getNumGrowths() < 40);
+	REQUIRE(signatureArray.getNumShrinks() == 0);
+
+	// Removing most signatures shrinks the memory
+	unsigned int memorySize = signatureArray.getMemorySize();
+	while( signatureArray.getNumSignatures() > 1000 )
+		signatureArray.remove(0);
+	REQUIRE(signatureArray.getNumShrinks() > 0);
+	if( layout == River::ECS::SignatureLayout::RowMajor )
+		REQUIRE(signatureArray.getMemorySize() < memorySize / 4);
+
+	signatureArray.shrinkToFit();
+	if( layout == River::ECS::SignatureLayout::RowMajor )
+		REQUIRE(signatureArray.getMemorySize() == 1000 * signatureArray.getSignatureCapacity() / 8);
+
+	// Removing index 0 removes the first signature, and then the last ones moved into it, so 1000 consecutive signatures remain
+	std::vector<unsigned int> bitCounts(10, 0);
+	River::ECS::Signature signature(10);
+	for( unsigned int bit = 0; bit < 10; bit++ ) {
+		signature.unsetAll();
+		signature.set(bit);
+		signatureArray.forMatchingSignatures(signature, [&bitCounts, bit](unsigned int signatureIndex) {
+			bitCounts[bit]++;
+		});
+	}
+	REQUIRE(bitCounts == std::vector<unsigned int>(10, 100));
+}
@@ -0,0 +1,122 @@
+#pragma once
+
+#include <catch.h>
+
+#include <set>
+
+#include <ECS.h>
+#include <ECS/StaticDomain.h>
+
+#include "TestComponents.h"
+#include "Log.h"
+
+
+
+using TestStaticDomain = River::ECS::StaticDomain<ComponentA, ComponentB, ComponentC>;
+
+static_assert(TestStaticDomain::getTypeIndex<ComponentB>() == 1, "Type index is resolved at compile time");
+static_assert(TestStaticDomain::getMask<ComponentA, ComponentC>()[0] == 0b101, "Mask is resolved at compile time");
+static_assert(TestStaticDomain::NUM_SIGNATURE_WORDS == 1, "Signature width is resolved at compile time");
+
+
+
+TEST_CASE("Static domain", "[static_domain]") {
+
+	TestStaticDomain domain;
+
+	std::vector<River::ECS::EntityId> entities;
+	for( int i = 0; i < 100; i++ ) {
+		auto entity = domain.createEntity();
+		domain.addComponent<ComponentA>(entity)->a = i;
+		if( i % 2 == 0 )
+			domain.addComponent<ComponentB>(entity)->a = i;
+		entities.push_back(entity);
+	}
+
+	// Not matched before cleaning
+	int entityCount = 0;
+	domain.forMatchingEntities<ComponentA>([&entityCount](auto entity, auto a) {
+		entityCount++;
+		});
+	REQUIRE(entityCount == 0);
+	REQUIRE(domain.getComponent<ComponentA>(entities[5])->a == 5);
+
+	domain.clean();
+	REQUIRE(domain.getNumEntities() == 100);
+
+	entityCount = 0;
+	domain.forMatchingEntities<ComponentA, ComponentB>([&entityCount, &domain](River::ECS::EntityId entity, ComponentA* a, ComponentB* b) {
+		REQUIRE(a->a % 2 == 0);
+		REQUIRE(b->a == a->a);
+		REQUIRE(domain.getComponent<ComponentA>(entity) == a);
+		entityCount++;
+		});
+	REQUIRE(entityCount == 50);
+	REQUIRE(domain.getComponent<ComponentC>(entities[0]) == nullptr);
+	REQUIRE_THROWS_AS(domain.addComponent<ComponentA>(entities[0]), River::ECS::MultipleComponentException);
+
+
+	SECTION("Removing components") {
+		for( int i = 0; i < 100; i += 4 )
+			domain.removeComponent<ComponentB>(entities[i]);
+		domain.clean();
+
+		entityCount = 0;
+		domain.forMatchingEntities<ComponentB>([&entityCount](auto entity, ComponentB* b) {
+			REQUIRE(b->a % 4 == 2);
+			entityCount++;
+			});
+		REQUIRE(entityCount == 25);
+		REQUIRE(domain.getComponent<ComponentB>(entities[0]) == nullptr);
+		REQUIRE(domain.getComponent<ComponentB>(entities[2])->a == 2);
+	}
+
+
+	SECTION("Destroying entities") {
+		for( int i = 0; i < 50; i++ )
+			domain.destroyEntity(entities[i]);
+		domain.destroyEntity(entities[0]);
+		domain.clean();
+		REQUIRE(domain.getNumEntities() == 50);
+
+		std::set<int> values;
+		domain.forMatchingEntities<ComponentA>([&values, &domain](River::ECS::EntityId entity, ComponentA* a) {
+			REQUIRE(a->a >= 50);
+			values.insert(a->a);
+			});
+		REQUIRE(values.size() == 50);
+		REQUIRE_THROWS_AS(domain.addComponent<ComponentA>(entities[0]), River::ECS::InvalidEntityException);
+
+		// EntityIds are reused
+		auto entity = domain.createEntity();
+		REQUIRE(entity <= entities[49]);
+		REQUIRE(domain.getComponent<ComponentA>(entity) == nullptr);
+		domain.addComponent<ComponentC>(entity);
+		domain.clean();
+
+		entityCount = 0;
+		domain.forMatchingEntities<ComponentC>([&entityCount, entity](River::ECS::EntityId matchedEntity, ComponentC* c) {
+			REQUIRE(matchedEntity == entity);
+			entityCount++;
+			});
+		REQUIRE(entityCount == 1);
+	}
+
+
+	SECTION("Same cycle add and remove") {
+		auto entity = domain.createEntity();
+		domain.addComponent<ComponentC>(entity);
+		domain.removeComponent<ComponentC>(entity);
+		auto destroyedEntity = domain.createEntity();
+		domain.addComponent<ComponentC>(destroyedEntity);
+		domain.destroyEntity(destroyedEntity);
+		domain.clean();
+
+		entityCount = 0;
+		domain.forMatchingEntities<ComponentC>([&entityCount](auto entity, auto c) {
+			entityCount++;
+			});
+		REQUIRE(entityCount == 0);
+		REQUIRE(domain.getNumEntities() == 101);
+	}
+}
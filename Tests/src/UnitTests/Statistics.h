@@ -0,0 +1,117 @@
+#pragma once
+
+#include <catch.h>
+
+#include <ECS.h>
+#include <ECS/Statistics.h>
+
+#include "TestComponents.h"
+#include "Log.h"
+
+
+
+TEST_CASE("Statistics JSON", "[statistics]") {
+
+	River::ECS::DomainStatistics statistics;
+	statistics.entitiesCreated = 3;
+	statistics.cleanNanoseconds = 1000;
+	statistics.componentTypes[2].name = "Some \"quoted\" type";
+	statistics.componentTypes[2].added = 5;
+	statistics.componentTypes[1].name = "Other type";
+	statistics.queries[{ 1, 2 }].numMatches = 7;
+
+	auto json = statistics.toJson();
+	REQUIRE(json.find("\"entitiesCreated\":3") != std::string::npos);
+	REQUIRE(json.find("\"cleanNanoseconds\":1000") != std::string::npos);
+	REQUIRE(json.find("\"name\":\"Some \\\"quoted\\\" type\",\"added\":5") != std::string::npos);
+	REQUIRE(json.find("\"componentTypes\":[1,2],\"numQueries\":0,\"numMatches\":7") != std::string::npos);
+	REQUIRE(json.find("\"id\":1") < json.find("\"id\":2"));
+
+	statistics.reset();
+	REQUIRE(statistics.entitiesCreated == 0);
+	REQUIRE(statistics.cleanNanoseconds == 0);
+	REQUIRE(statistics.queries.empty());
+	REQUIRE(statistics.componentTypes.size() == 2);
+	REQUIRE(statistics.componentTypes[2].added == 0);
+	REQUIRE(statistics.componentTypes[2].name == "Some \"quoted\" type");
+}
+
+
+
+TEST_CASE("Cache line statistics", "[statistics]") {
+
+	River::ECS::ComponentTypeStatistics statistics;
+	statistics.numComponents = 8;
+
+	// 24 byte elements from the start of a cache line: the 3rd and 6th element cross into the next line
+	statistics.recordArrayLayout((const void*)64, 24, 8);
+	REQUIRE(statistics.componentSize == 24);
+	REQUIRE(statistics.cacheLines == 3);
+	REQUIRE(statistics.straddlingComponents == 2);
+	REQUIRE(statistics.getCacheLineUtilization() == 1.0);
+
+	// 16 byte elements from the middle of a cache line never straddle
+	statistics = River::ECS::ComponentTypeStatistics();
+	statistics.numComponents = 100;
+	statistics.recordArrayLayout((const void*)(64 * 3 + 32), 16, 100);
+	REQUIRE(statistics.straddlingComponents == 0);
+	REQUIRE(statistics.cacheLines == 26);
+
+	// Elements larger than a cache line straddle if they occupy more lines than needed
+	statistics = River::ECS::ComponentTypeStatistics();
+	statistics.recordArrayLayout((const void*)(64 + 48), 96, 4);
+	REQUIRE(statistics.straddlingComponents == 2);
+	statistics.recordArrayLayout((const void*)64, 128, 4);
+	REQUIRE(statistics.straddlingComponents == 2);
+	REQUIRE(statistics.componentSize == 96 + 128);
+}
+
+
+
+TEST_CASE("Domain statistics", "[statistics]") {
+
+	River::ECS::Domain domain;
+
+	std::vector<River::ECS::Entity*> entities;
+	for( int i = 0; i < 10; i++ ) {
+		auto entity = domain.createEntity();
+		entity->addComponent<ComponentA>();
+		if( i % 2 == 0 )
+			entity->addComponent<ComponentB>();
+		entities.push_back(entity);
+	}
+	domain.clean();
+
+	entities[0]->destroy();
+	entities[1]->removeComponent<ComponentA>();
+	domain.forMatchingEntities<ComponentA, ComponentB>([](River::ECS::Entity*, ComponentA*, ComponentB*) {});
+	domain.forMatchingEntities<ComponentA, ComponentB>([](River::ECS::Entity*, ComponentA*, ComponentB*) {});
+	domain.clean();
+
+	auto& statistics = domain.getStatistics();
+
+#ifdef RV_ECS_ENABLE_STATISTICS
+	REQUIRE(statistics.entitiesCreated == 0);
+	REQUIRE(statistics.entitiesDestroyed == 1);
+	REQUIRE(statistics.cleanNanoseconds > 0);
+
+	auto& componentA = statistics.componentTypes.at(River::ECS::ComponentTypeRegistry::getTypeId<ComponentA>());
+	REQUIRE(componentA.added == 0);
+	REQUIRE(componentA.removed == 2);
+	REQUIRE(componentA.name.find("ComponentA") != std::string::npos);
+	REQUIRE(componentA.numComponents == 8);
+	REQUIRE(componentA.componentSize == sizeof(ComponentA));
+	REQUIRE(componentA.cacheLines > 0);
+
+	std::vector<River::ECS::ComponentTypeId> query = {
+		River::ECS::ComponentTypeRegistry::getTypeId<ComponentA>(),
+		River::ECS::ComponentTypeRegistry::getTypeId<ComponentB>()
+	};
+	REQUIRE(statistics.queries.at(query).numQueries == 2);
+	REQUIRE(statistics.queries.at(query).numMatches == 10);
+#else
+	// Statistics are compiled out
+	REQUIRE(statistics.entitiesDestroyed == 0);
+	REQUIRE(statistics.queries.empty());
+#endif
+}
@@ -0,0 +1,123 @@
+#pragma once
+
+#include <catch.h>
+
+#include <sstream>
+#include <thread>
+#include <cstring>
+
+#include <ECS.h>
+#include <ECS/Tracing.h>
+
+#include "TestComponents.h"
+#include "Log.h"
+
+
+
+// Counts the recorded events with the given name
+unsigned int countTraceEvents(const char* name) {
+	unsigned int count = 0;
+	River::ECS::Tracing::forEachEvent([name, &count](unsigned int, const River::ECS::TraceEvent& event) {
+		if( std::strcmp(event.name, name) == 0 ) count++;
+	});
+	return count;
+}
+
+
+
+TEST_CASE("Tracing", "[tracing]") {
+
+	River::ECS::Tracing::clear();
+
+	{
+		River::ECS::TraceScope outer("Outer", "some \"detail\"");
+		River::ECS::TraceScope inner("First");
+		inner.next("Second");
+	}
+	REQUIRE(countTraceEvents("Outer") == 1);
+	REQUIRE(countTraceEvents("First") == 1);
+	REQUIRE(countTraceEvents("Second") == 1);
+
+
+	SECTION("Chrome trace") {
+		std::ostringstream stream;
+		River::ECS::Tracing::writeChromeTrace(stream);
+		auto json = stream.str();
+		REQUIRE(json.find("{\"traceEvents\":[") == 0);
+		REQUIRE(json.find("\"name\":\"Outer\"") != std::string::npos);
+		REQUIRE(json.find("\"args\":{\"detail\":\"some \\\"detail\\\"\"}") != std::string::npos);
+		REQUIRE(json.find("\"ph\":\"X\"") != std::string::npos);
+	}
+
+
+	SECTION("Perfetto trace") {
+		std::ostringstream stream;
+		River::ECS::Tracing::writePerfettoTrace(stream);
+		auto trace = stream.str();
+
+		// The trace is a sequence of 'packet' fields (field 1, length-delimited):
+		// one track descriptor, and a begin and an end per event
+		unsigned int numPackets = 0;
+		size_t i = 0;
+		while( i < trace.size() ) {
+			REQUIRE(trace[i] == 0x0A);
+			uint64_t length = 0;
+			unsigned int shift = 0;
+			unsigned char byte;
+			do {
+				byte = (unsigned char)trace[++i];
+				length |= (uint64_t)(byte & 0x7F) << shift;
+				shift += 7;
+			} while( byte & 0x80 );
+			i += 1 + length;
+			numPackets++;
+		}
+		REQUIRE(i == trace.size());
+		REQUIRE(numPackets == 1 + 3 * 2);
+		REQUIRE(trace.find("Outer (some \"detail\")") != std::string::npos);
+	}
+
+
+	SECTION("Events of other threads") {
+		std::thread thread([]() {
+			River::ECS::TraceScope scope("Other thread");
+		});
+		thread.join();
+
+		unsigned int threadIndex = 0;
+		River::ECS::Tracing::forEachEvent([&threadIndex](unsigned int eventThreadIndex, const River::ECS::TraceEvent& event) {
+			if( std::strcmp(event.name, "Other thread") == 0 ) threadIndex = eventThreadIndex;
+		});
+		REQUIRE(threadIndex != 0);
+		REQUIRE(countTraceEvents("Outer") == 1);
+	}
+
+
+	SECTION("Full buffer") {
+		for( unsigned int i = 0; i < River::ECS::Tracing::BUFFER_CAPACITY; i++ )
+			River::ECS::TraceScope scope("Filler");
+		REQUIRE(countTraceEvents("Filler") == River::ECS::Tracing::BUFFER_CAPACITY);
+		REQUIRE(countTraceEvents("Outer") == 0);
+	}
+
+
+	SECTION("Clear") {
+		River::ECS::Tracing::clear();
+		REQUIRE(countTraceEvents("Outer") == 0);
+	}
+
+
+#ifdef RV_ECS_ENABLE_TRACING
+	SECTION("Domain events") {
+		River::ECS::Domain domain;
+		domain.createEntity()->addComponent<ComponentA>();
+		domain.clean();
+		domain.forMatchingEntities<ComponentA>([](River::ECS::Entity*, ComponentA*) {});
+
+		REQUIRE(countTraceEvents("Domain::clean") == 1);
+		REQUIRE(countTraceEvents("Domain::clean: destroy entities") == 1);
+		REQUIRE(countTraceEvents("ComponentController::clean") == 1);
+		REQUIRE(countTraceEvents("Domain::forMatchingEntities") == 1);
+	}
+#endif
+}
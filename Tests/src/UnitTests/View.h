@@ -0,0 +1,280 @@
+#pragma once
+
+#include <catch.h>
+
+#include <algorithm>
+#include <chrono>
+#include <random>
+#include <type_traits>
+
+#include <ECS.h>
+#include <ECS/View.h>
+
+#include "MemoryResource.h"
+#include "TestComponents.h"
+#include "Log.h"
+
+
+
+static_assert(std::is_trivially_copyable<River::ECS::View<ComponentA, ComponentB>::Iterator>::value, "View iterators are trivially copyable");
+
+
+
+TEST_CASE("Views", "[view]") {
+
+	River::ECS::Domain domain;
+
+	std::vector<River::ECS::Entity*> entities;
+	for( int i = 0; i < 100; i++ ) {
+		auto entity = domain.createEntity();
+		entity->addComponent<ComponentA>()->a = i;
+		if( i % 2 == 0 )
+			entity->addComponent<ComponentB>()->a = i * 2;
+		entities.push_back(entity);
+	}
+
+	// Not matched before cleaning
+	REQUIRE(domain.view<ComponentA>().empty());
+
+	domain.clean();
+
+
+	SECTION("Structured bindings") {
+		int numMatches = 0;
+		for( auto [entity, a, b] : domain.view<ComponentA, ComponentB>() ) {
+			REQUIRE(&a == entity->getComponent<ComponentA>());
+			REQUIRE(&b == entity->getComponent<ComponentB>());
+			REQUIRE(b.a == a.a * 2);
+			numMatches++;
+		}
+		REQUIRE(numMatches == 50);
+	}
+
+
+	SECTION("Modify components") {
+		for( auto [entity, a] : domain.view<ComponentA>() )
+			a.b = a.a + 1;
+
+		for( int i = 0; i < 100; i++ )
+			REQUIRE(entities[i]->getComponent<ComponentA>()->b == i + 1);
+	}
+
+
+	SECTION("Algorithms and random access") {
+		auto view = domain.view<ComponentA, ComponentB>();
+		REQUIRE(view.size() == 50);
+		REQUIRE(view.end() - view.begin() == 50);
+
+		auto match = std::find_if(view.begin(), view.end(), [](auto match) {
+			return std::get<1>(match).a == 42;
+		});
+		REQUIRE(match != view.end());
+		REQUIRE(std::get<0>(*match) == entities[42]);
+
+		auto count = std::count_if(view.begin(), view.end(), [](auto match) {
+			return std::get<1>(match).a < 10;
+		});
+		REQUIRE(count == 5);
+
+		auto last = view.begin() + 49;
+		REQUIRE(std::get<0>(*last) == std::get<0>(view[49]));
+		REQUIRE(std::get<0>(last[-49]) == std::get<0>(*view.begin()));
+	}
+
+
+	SECTION("Component type which hasn't been used") {
+		REQUIRE(domain.view<ComponentA, ComponentC>().size() == 0);
+	}
+
+
+	SECTION("Destroyed entities and removed components") {
+		entities[0]->destroy();
+		entities[2]->removeComponent<ComponentB>();
+		domain.clean();
+		REQUIRE(domain.view<ComponentA>().size() == 99);
+		REQUIRE(domain.view<ComponentA, ComponentB>().size() == 48);
+	}
+}
+
+
+
+TEST_CASE("Views are stored in the frame arena", "[view]") {
+
+	CountingMemoryResource resource;
+	River::ECS::DomainSettings settings;
+	settings.memoryResource = &resource;
+	River::ECS::Domain domain(settings);
+
+	for( int i = 0; i < 100; i++ ) {
+		auto entity = domain.createEntity();
+		entity->addComponent<ComponentA>();
+		entity->addComponent<ComponentB>();
+	}
+	domain.clean();
+
+	auto runFrame = [&domain]() {
+		for( int i = 0; i < 10; i++ ) {
+			size_t numMatches = 0;
+			for( auto [entity, a, b] : domain.view<ComponentA, ComponentB>() )
+				numMatches++;
+			REQUIRE(numMatches == 100);
+		}
+		domain.clean();
+	};
+
+	// Once the arena has grown to fit a frame's views, creating them doesn't allocate from the Domain's memory resource
+	runFrame();
+	auto numAllocations = resource.numAllocations;
+	for( int i = 0; i < 3; i++ )
+		runFrame();
+	REQUIRE(resource.numAllocations == numAllocations);
+}
+
+
+
+TEST_CASE("Chunks", "[view]") {
+
+	River::ECS::Domain domain;
+
+	std::vector<River::ECS::Entity*> entities;
+	for( int i = 0; i < 100; i++ ) {
+		auto entity = domain.createEntity();
+		entity->addComponent<ComponentA>()->a = i;
+		entity->addComponent<ComponentB>()->a = i * 2;
+		entities.push_back(entity);
+	}
+	domain.clean();
+
+	// Checks that the chunks' arrays are the matching entities' components
+	auto checkChunks = [&domain](size_t alignment) {
+		unsigned int numChunks = 0;
+		size_t numMatches = 0;
+		domain.forEachChunk<ComponentA, ComponentB>([&](River::ECS::Entity* const* chunkEntities, size_t count, ComponentA* a, ComponentB* b) {
+			REQUIRE(count > 0);
+			for( size_t i = 0; i < count; i++ ) {
+				REQUIRE(&a[i] == chunkEntities[i]->getComponent<ComponentA>());
+				REQUIRE(&b[i] == chunkEntities[i]->getComponent<ComponentB>());
+				REQUIRE(b[i].a == a[i].a * 2);
+			}
+			numChunks++;
+			numMatches += count;
+		}, alignment);
+		REQUIRE(numMatches == domain.view<ComponentA, ComponentB>().size());
+		return numChunks;
+	};
+
+
+	SECTION("Contiguous components") {
+		REQUIRE(checkChunks(0) == 1);
+	}
+
+
+	SECTION("Removed components") {
+		entities[10]->destroy();
+		entities[50]->removeComponent<ComponentB>();
+		domain.clean();
+		REQUIRE(checkChunks(0) > 1);
+	}
+
+
+	SECTION("Alignment") {
+		std::vector<ComponentA*> chunkStarts;
+		domain.forEachChunk<ComponentA>([&chunkStarts](River::ECS::Entity* const*, size_t count, ComponentA* a) {
+			chunkStarts.push_back(a);
+		}, 64);
+
+		// An unaligned start is split off of the run
+		REQUIRE(chunkStarts.size() <= 2);
+		REQUIRE(reinterpret_cast<uintptr_t>(chunkStarts.back()) % 64 == 0);
+		REQUIRE(checkChunks(sizeof(ComponentA)) >= 1);
+	}
+}
+
+
+
+/**
+ * @brief	Creates entities whose ComponentA and ComponentB are added in random order (so the components aren't in
+ *			the order of the signatures), and destroys and recreates some of them
+*/
+void createScatteredEntities(River::ECS::Domain& domain, int numEntities) {
+	std::mt19937 random(1);
+	std::vector<River::ECS::Entity*> entities;
+	for( int i = 0; i < numEntities; i++ )
+		entities.push_back(domain.createEntity());
+	domain.clean();
+
+	std::shuffle(entities.begin(), entities.end(), random);
+	for( int i = 0; i < numEntities; i++ ) {
+		if( i % 2 == 0 )
+			entities[i]->addComponent<ComponentA>()->a = i;
+		if( i % 3 == 0 )
+			entities[i]->addComponent<ComponentB>()->a = i;
+	}
+	domain.clean();
+
+	std::shuffle(entities.begin(), entities.end(), random);
+	for( int i = 0; i < numEntities / 4; i++ ) {
+		entities[i]->destroy();
+		auto entity = domain.createEntity();
+		entity->addComponent<ComponentA>();
+		if( i % 2 == 0 )
+			entity->addComponent<ComponentB>();
+	}
+	domain.clean();
+}
+
+
+TEST_CASE("Batched queries match views", "[view]") {
+
+	River::ECS::Domain domain;
+	createScatteredEntities(domain, 1000);
+
+	// The batched query and the view both go through the signatures in order
+	auto view = domain.view<ComponentA, ComponentB>();
+	REQUIRE(view.size() > 64);
+
+	auto iterator = view.begin();
+	size_t numMatches = 0;
+	domain.forMatchingEntities<ComponentA, ComponentB>([&](River::ECS::Entity* entity, ComponentA* a, ComponentB* b) {
+		auto [viewEntity, viewA, viewB] = *iterator;
+		REQUIRE(entity == viewEntity);
+		REQUIRE(a == &viewA);
+		REQUIRE(b == &viewB);
+		REQUIRE(a == entity->getComponent<ComponentA>());
+		REQUIRE(b == entity->getComponent<ComponentB>());
+		++iterator;
+		numMatches++;
+	});
+	REQUIRE(numMatches == view.size());
+}
+
+
+TEST_CASE("Batched query benchmark", "[.][benchmark]") {
+
+	River::ECS::Domain domain;
+	createScatteredEntities(domain, 4000000);
+
+	auto measure = [](auto function) {
+		double best = 0;
+		for( int i = 0; i < 5; i++ ) {
+			auto start = std::chrono::steady_clock::now();
+			function();
+			double milliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+			best = i == 0 ? milliseconds : std::min(best, milliseconds);
+		}
+		return best;
+	};
+
+	long long sum = 0;
+	double batched = measure([&]() {
+		domain.forMatchingEntities<ComponentA, ComponentB>([&sum](River::ECS::Entity*, ComponentA* a, ComponentB* b) {
+			sum += a->a + b->a;
+		});
+	});
+	double unbatched = measure([&]() {
+		for( auto [entity, a, b] : domain.view<ComponentA, ComponentB>() )
+			sum += a.a + b.a;
+	});
+
+	LOG("Batched query: " << batched << " ms, view: " << unbatched << " ms (" << sum << ")");
+}
@@ -0,0 +1,67 @@
+#pragma once
+
+#include <cstddef>
+#include <memory_resource>
+
+
+namespace River::ECS {
+
+	/**
+	 * @brief	Allocator which allocates from a memory resource (like std::pmr::polymorphic_allocator), but aligns
+	 *			all allocations to at least the given alignment
+	 * @tparam	Alignment	Minimum alignment in bytes (must be a power of two)
+	*/
+	template <typename T, size_t Alignment>
+	class AlignedAllocator {
+		static_assert(Alignment > 0 && (Alignment & (Alignment - 1)) == 0, "Alignment must be a power of two");
+		inline static const size_t ALIGNMENT = Alignment > alignof(T) ? Alignment : alignof(T);
+
+	public:
+		using value_type = T;
+
+		template <typename U>
+		struct rebind {
+			using other = AlignedAllocator<U, Alignment>;
+		};
+
+
+		AlignedAllocator(std::pmr::memory_resource* memoryResource = std::pmr::get_default_resource()) :
+			memoryResource(memoryResource)
+		{}
+
+		template <typename U>
+		AlignedAllocator(const AlignedAllocator<U, Alignment>& other) :
+			memoryResource(other.getMemoryResource())
+		{}
+
+
+		T* allocate(size_t n) {
+			return static_cast<T*>(memoryResource->allocate(n * sizeof(T), ALIGNMENT));
+		}
+
+		void deallocate(T* pointer, size_t n) {
+			memoryResource->deallocate(pointer, n * sizeof(T), ALIGNMENT);
+		}
+
+
+		std::pmr::memory_resource* getMemoryResource() const {
+			return memoryResource;
+		}
+
+
+		template <typename U>
+		bool operator==(const AlignedAllocator<U, Alignment>& other) const {
+			return memoryResource == other.getMemoryResource() || memoryResource->is_equal(*other.getMemoryResource());
+		}
+
+		template <typename U>
+		bool operator!=(const AlignedAllocator<U, Alignment>& other) const {
+			return !(*this == other);
+		}
+
+
+	private:
+		std::pmr::memory_resource* memoryResource;
+	};
+
+}
@@ -0,0 +1,40 @@
+#pragma once
+
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+
+namespace River::ECS {
+
+	/**
+	 * @brief	Appends variable-length integers and raw bytes to a byte buffer
+	*/
+	class ByteWriter {
+	public:
+
+		ByteWriter(std::vector<unsigned char>& buffer) : buffer(buffer) {}
+
+
+		/**
+		 * @brief	Writes the value as a LEB128 varint (7 bits per byte, lowest bits first)
+		*/
+		void writeVarUInt(uint64_t value) {
+			while( value >= 0x80 ) {
+				buffer.push_back((unsigned char)(value | 0x80));
+				value >>= 7;
+			}
+			buffer.push_back((unsigned char)value);
+		}
+
+
+		void writeBytes(const unsigned char* bytes, size_t numBytes) {
+			buffer.insert(buffer.end(), bytes, bytes + numBytes);
+		}
+
+
+	private:
+		std::vector<unsigned char>& buffer;
+	};
+
+}
@@ -2,6 +2,8 @@
 
 #include <type_traits>
 #include <string>
+#include <limits>
+#include <cstdint>
 
 
 namespace River::ECS {
@@ -42,6 +44,12 @@ namespace River::ECS {
 
 		template<typename C>
 		friend class ComponentController;
+
+		template<typename C, typename Descriptor>
+		friend class ComponentFieldArrays;
+
+		template<typename C>
+		friend class ComponentFieldsRef;
 	};
 
 
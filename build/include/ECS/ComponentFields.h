@@ -0,0 +1,332 @@
+#pragma once
+
+#include <cstddef>
+#include <tuple>
+#include <vector>
+#include <type_traits>
+#include <algorithm>
+#include <memory_resource>
+
+#include "Component.h"
+#include "AlignedAllocator.h"
+#include "MemoryReport.h"
+#include "Statistics.h"
+
+
+/**
+ * @brief	Makes the component type be stored as a structure of arrays, with each of the given fields in its own
+ *			array (see River::ECS::ComponentFields). Must be used in the global namespace:
+ *
+ *			RV_ECS_COMPONENT_FIELDS(Position, &Position::x, &Position::y, &Position::z);
+*/
+#define RV_ECS_COMPONENT_FIELDS(C, ...) \
+	namespace River::ECS { template <> struct ComponentFields<C> : Fields<__VA_ARGS__> {}; }
+
+/**
+ * @brief	Sets the byte alignment of the array which the component type is stored in (see
+ *			River::ECS::ComponentAlignment). Must be used in the global namespace:
+ *
+ *			RV_ECS_COMPONENT_ALIGNMENT(Transform, 64);
+*/
+#define RV_ECS_COMPONENT_ALIGNMENT(C, alignment) \
+	namespace River::ECS { template <> struct ComponentAlignment<C> { inline static const size_t VALUE = alignment; }; }
+
+
+namespace River::ECS {
+
+	/**
+	 * @brief	Describes how a component type is stored. By default, components are stored as an array of
+	 *			structures. Specializing this with RV_ECS_COMPONENT_FIELDS makes the type be stored as a structure of
+	 *			arrays: each of its fields in its own (cache line aligned) array. Fields which aren't listed aren't
+	 *			stored, and they have their default value when a cleaned component is read as a whole.
+	*/
+	template <typename C>
+	struct ComponentFields {
+		inline static const bool IS_SOA = false;
+		using Descriptor = void;
+	};
+
+
+	/**
+	 * @brief	Byte alignment of the array which a component type's cleaned components are stored in (by default the
+	 *			alignment of the type). Specialize with RV_ECS_COMPONENT_ALIGNMENT. If the component size divides the
+	 *			alignment, or is a multiple of it, components don't straddle more cache lines than they have to.
+	 *			Doesn't apply to types stored as a structure of arrays (their arrays are aligned to cache lines).
+	*/
+	template <typename C>
+	struct ComponentAlignment {
+		inline static const size_t VALUE = alignof(C);
+	};
+
+
+	template <typename M>
+	struct MemberPointerTraits;
+
+	template <typename T, typename C>
+	struct MemberPointerTraits<T C::*> {
+		using Type = T;
+		using Class = C;
+	};
+
+	/**
+	 * @brief The type of the field, which the member pointer points to */
+	template <auto Field>
+	using FieldType = typename MemberPointerTraits<decltype(Field)>::Type;
+
+	// Gives each field (member pointer) its own type, so fields can be compared at compile time
+	template <auto Field>
+	struct FieldTag {};
+
+
+	/**
+	 * @brief	List of the fields of a component type, which are stored in their own arrays (see ComponentFields)
+	*/
+	template <auto ... F>
+	struct Fields {
+		inline static const bool IS_SOA = true;
+		using Descriptor = Fields<F...>;
+
+		static const size_t NUM_FIELDS = sizeof...(F);
+
+		/**
+		 * @return	Index of the field in the list of fields
+		*/
+		template <auto Field>
+		static constexpr size_t getIndex() {
+			constexpr bool matches[] = { std::is_same<FieldTag<Field>, FieldTag<F>>::value... };
+			for( size_t i = 0; i < NUM_FIELDS; i++ ) {
+				if( matches[i] ) return i;
+			}
+			return NUM_FIELDS;
+		}
+	};
+
+
+	/**
+	 * @brief The byte alignment of each of the arrays of a structure of arrays (a cache line) */
+	const size_t FIELD_ARRAY_ALIGNMENT = 64;
+
+	template <typename T>
+	using FieldArray = std::vector<T, AlignedAllocator<T, FIELD_ARRAY_ALIGNMENT>>;
+
+
+	template <typename C, typename Descriptor = typename ComponentFields<C>::Descriptor>
+	class ComponentFieldArrays;
+
+	/**
+	 * @brief	The components of a structure of arrays type: an array of the component ids, and an array of each field
+	*/
+	template <typename C, auto ... F>
+	class ComponentFieldArrays<C, Fields<F...>> {
+		static_assert((std::is_same<typename MemberPointerTraits<decltype(F)>::Class, C>::value && ...), "Fields must be members of the component type");
+		static_assert((!std::is_same<FieldType<F>, bool>::value && ...), "Fields of type bool can't be stored in their own arrays");
+
+		using Descriptor = Fields<F...>;
+
+	public:
+
+		ComponentFieldArrays(std::pmr::memory_resource* memoryResource) :
+			ids(memoryResource),
+			arrays(FieldArray<FieldType<F>>(AlignedAllocator<FieldType<F>, FIELD_ARRAY_ALIGNMENT>(memoryResource))...)
+		{}
+
+
+		/**
+		 * @return	The array of the field
+		*/
+		template <auto Field>
+		FieldType<Field>* getArray() {
+			constexpr size_t index = Descriptor::template getIndex<Field>();
+			static_assert(index < Descriptor::NUM_FIELDS, "Field is not one of the component type's fields");
+			return std::get<index>(arrays).data();
+		}
+
+
+		ComponentId getId(size_t index) const {
+			return ids[index];
+		}
+
+
+		/**
+		 * @brief	Stores the component's fields at the index
+		*/
+		void set(size_t index, const C& component) {
+			ids[index] = component.id;
+			((getArray<F>()[index] = component.*F), ...);
+		}
+
+
+		/**
+		 * @return	Copy of the component at the index
+		*/
+		C get(size_t index) {
+			C component;
+			component.id = ids[index];
+			((component.*F = getArray<F>()[index]), ...);
+			return component;
+		}
+
+
+		/**
+		 * @brief	Moves the component at index 'from' to index 'to'
+		*/
+		void move(size_t from, size_t to) {
+			ids[to] = ids[from];
+			((getArray<F>()[to] = std::move(getArray<F>()[from])), ...);
+		}
+
+
+		void resize(size_t size) {
+			ids.resize(size);
+			std::apply([size](auto& ... array) { (array.resize(size), ...); }, arrays);
+		}
+
+
+		size_t size() const {
+			return ids.size();
+		}
+
+
+		/**
+		 * @brief	Copies the first 'count' components of the other arrays (growing these arrays if needed)
+		*/
+		void copyFrom(const ComponentFieldArrays& other, size_t count) {
+			if( size() < count )
+				resize(count);
+			std::copy(other.ids.begin(), other.ids.begin() + count, ids.begin());
+			copyArrays(other, count, std::index_sequence_for<decltype(F)...>());
+		}
+
+
+		/**
+		 * @brief	Records the layout of the field arrays (of which the first 'count' components are in use)
+		*/
+		void recordLayoutStatistics(size_t count, ComponentTypeStatistics& statistics) const {
+			std::apply([&statistics, count](auto& ... array) {
+				(statistics.recordArrayLayout(array.data(), sizeof(array[0]), count), ...);
+			}, arrays);
+		}
+
+
+		/**
+		 * @return	Memory of the arrays, of which the first 'count' components are in use
+		*/
+		MemoryUsage getMemoryUsage(size_t count) const {
+			MemoryUsage usage = { count * sizeof(ComponentId), ids.capacity() * sizeof(ComponentId) };
+			std::apply([&usage, count](auto& ... array) {
+				((usage += { count * sizeof(array[0]), array.capacity() * sizeof(array[0]) }), ...);
+			}, arrays);
+			return usage;
+		}
+
+
+	private:
+		template <size_t ... I>
+		void copyArrays(const ComponentFieldArrays& other, size_t count, std::index_sequence<I...>) {
+			(std::copy(std::get<I>(other.arrays).begin(), std::get<I>(other.arrays).begin() + count, std::get<I>(arrays).begin()), ...);
+		}
+
+
+	private:
+		std::pmr::vector<ComponentId> ids;
+		std::tuple<FieldArray<FieldType<F>>...> arrays;
+	};
+
+
+	/**
+	 * @brief	Nullable reference to a component of a structure of arrays type, which is either a newly created
+	 *			component (which is stored as a whole until it's cleaned) or a cleaned component in the field arrays.
+	 *			Fields are accessed with get(): component.get<&Position::x>() = 10;
+	 *
+	 * @details	Like a component pointer, the reference is invalidated when its controller is cleaned.
+	*/
+	template <typename C>
+	class ComponentFieldsRef {
+	public:
+
+		ComponentFieldsRef(std::nullptr_t = nullptr) {}
+
+		ComponentFieldsRef(C* component) : component(component) {}
+
+		ComponentFieldsRef(ComponentFieldArrays<C>* arrays, unsigned int index) : arrays(arrays), index(index) {}
+
+
+		/**
+		 * @return	Reference to the field of the component
+		*/
+		template <auto Field>
+		FieldType<Field>& get() const {
+			if( component != nullptr )
+				return component->*Field;
+			return arrays->template getArray<Field>()[index];
+		}
+
+
+		/**
+		 * @return	Copy of the component (fields which aren't stored have their default value)
+		*/
+		C load() const {
+			return component != nullptr ? *component : arrays->get(index);
+		}
+
+
+		/**
+		 * @brief	Overwrites the stored fields of the component (the id of the component is kept)
+		*/
+		void store(const C& value) const {
+			C copy = value;
+			setId(copy, getId());
+			if( component != nullptr )
+				*component = copy;
+			else
+				arrays->set(index, copy);
+		}
+
+
+		ComponentId getId() const {
+			return component != nullptr ? static_cast<Component*>(component)->id : arrays->getId(index);
+		}
+
+
+		explicit operator bool() const {
+			return component != nullptr || arrays != nullptr;
+		}
+
+		bool operator==(std::nullptr_t) const {
+			return !*this;
+		}
+
+		bool operator!=(std::nullptr_t) const {
+			return (bool)*this;
+		}
+
+		bool operator==(const ComponentFieldsRef& other) const {
+			return component == other.component && arrays == other.arrays && index == other.index;
+		}
+
+		bool operator!=(const ComponentFieldsRef& other) const {
+			return !(*this == other);
+		}
+
+
+	private:
+		static void setId(C& component, ComponentId id) {
+			static_cast<Component&>(component).id = id;
+		}
+
+
+	private:
+		C* component = nullptr;
+		ComponentFieldArrays<C>* arrays = nullptr;
+		unsigned int index = 0;
+	};
+
+
+	/**
+	 * @brief	The type which the Domain hands out for a component: a pointer, or a ComponentFieldsRef if the type is
+	 *			stored as a structure of arrays
+	*/
+	template <typename C>
+	using ComponentPointer = std::conditional_t<ComponentFields<C>::IS_SOA, ComponentFieldsRef<C>, C*>;
+
+}
@@ -4,10 +4,23 @@
 #include <unordered_set>
 #include <unordered_map>
 #include <functional>
+#include <memory>
+#include <memory_resource>
+#include <typeinfo>
+#include <tuple>
+#include <limits>
+#include <algorithm>
 
 #include "ComponentTypeRegistry.h"
 #include "ComponentController.h"
+#include "ComponentRef.h"
+#include "View.h"
+#include "Prefetch.h"
 #include "Component.h"
+#include "FrameArena.h"
+#include "Statistics.h"
+#include "Tracing.h"
+#include "MemoryReport.h"
 
 #include "SignatureArray/Signature.h"
 #include "SignatureArray/SignatureArray.h"
@@ -16,62 +29,251 @@
 namespace River::ECS {
 
 	struct Entity;
+	class DomainSnapshot;
+	class ChangeTracker;
+
+	// Thrown if an operation requires the Domain to be cleaned first
+	class DomainNotCleanException : public Exception {
+	public:
+		DomainNotCleanException(const std::string& operation) : Exception("Domain must be cleaned before " + operation) {}
+	};
+
+	// Identifies an Entity within its Domain
+	using EntityId = uint32_t;
+
+	/**
+	 * @brief The default "null" EntityId
+	*/
+	const EntityId NULL_ENTITY_ID = 0;
+
+
+	/**
+	 * @brief	Options for creating a Domain
+	*/
+	struct DomainSettings {
+
+		/**
+		 * @brief	Resource which all of the Domain's memory (entities, components, signatures and internal
+		 *			containers) is allocated from. Must outlive the Domain. */
+		std::pmr::memory_resource* memoryResource = std::pmr::get_default_resource();
+
+		/**
+		 * @brief	If true, the Domain allocates from its own pool arena (which gets its memory from memoryResource).
+		 *			The arena's memory is released all at once when the Domain is destroyed. */
+		bool useArena = false;
+
+		/**
+		 * @brief	Initial size in bytes of the arena holding the changes made between cleans. The arena grows to
+		 *			fit the largest number of changes made between two cleans. */
+		size_t frameArenaSize = 16384;
+
+		/**
+		 * @brief	How entity signatures are stored. ColumnMajor makes registering new component types and
+		 *			destroying entities cheaper, but a signature's bits are no longer contiguous. */
+		SignatureLayout signatureLayout = SignatureLayout::RowMajor;
+
+		/**
+		 * @brief	Number of component types the entity signatures have room for up front (always at least one word
+		 *			of 64 types). If more component types are used, the room is doubled, which moves all signatures
+		 *			(with the RowMajor layout). */
+		unsigned int reservedComponentTypes = 0;
+	};
+
 
 	class Domain {
 	public:
 
-		Domain();
+		Domain(const DomainSettings& settings = DomainSettings());
 		~Domain();
 
 
 		Entity* createEntity();
 
 
+		/**
+		 * @brief	Creates the controllers and signature bits of the component types up front, instead of when the
+		 *			types are first used (the ids are registered in the ComponentTypeRegistry as well)
+		*/
+		template <typename ... C>
+		void registerComponents() {
+			(getComponentController<C>(), ...);
+		}
+
+
 		template <typename C>
 		C* addEntityComponent(Entity* entity) {
 			RV_ECS_ASSERT_COMPONENT_TYPE(C);
 			auto componentController = getComponentController<C>();		
 			auto component = componentController->createComponent(entity);
 
-			entityComponentsToCreate[entity].push_back(ComponentTypeRegistry::getTypeId<C>());
+			auto typeId = ComponentTypeRegistry::getTypeId<C>();
+			entityComponentsToCreate.emplace_back(entity, typeId);
+			markControllerDirty(getSignatureBit(typeId));
 			return component;
 		}
 
 
 
 		template <typename C>
-		C* getEntityComponent(Entity* entity) {
+		ComponentPointer<C> getEntityComponent(Entity* entity) {
 			RV_ECS_ASSERT_COMPONENT_TYPE(C);
 			auto componentController = getComponentController<C>();
 			return componentController->getComponent(entity);
 		}
 
 
+		/**
+		 * @brief	Creates a handle for index-based access to the Domain's components of type C, which is
+		 *			valid until the Domain is cleaned (see ComponentRef)
+		*/
+		template <typename C>
+		ComponentRef<C> getComponentRef() {
+			return ComponentRef<C>(getComponentController<C>(), &cleanEpoch);
+		}
+
+
+		/**
+		 * @return	A ComponentRef for each of the component types (i.e. for structured bindings)
+		*/
+		template <typename ... C>
+		std::tuple<ComponentRef<C>...> getComponentRefs() {
+			return { getComponentRef<C>()... };
+		}
+
+
+		/**
+		 * @return	Whether the Domain has used the component type (i.e. whether it has a bit in the signatures). Unlike
+		 *			the other component functions, this doesn't register the type.
+		*/
+		template <typename C>
+		bool usesComponentType() const {
+			RV_ECS_ASSERT_COMPONENT_TYPE(C);
+			return getSignatureBit(ComponentTypeRegistry::getTypeId<C>()) != NO_SIGNATURE_BIT;
+		}
+
+
 		template <typename C>
 		void removeEntityComponent(Entity* entity) {
 			RV_ECS_ASSERT_COMPONENT_TYPE(C);
-			entityComponentsToDelete[entity].push_back(ComponentTypeRegistry::getTypeId<C>());
+			auto typeId = ComponentTypeRegistry::getTypeId<C>();
+			if( getSignatureBit(typeId) == NO_SIGNATURE_BIT )
+				return; // No entity can have a component type which the Domain hasn't used
+			entityComponentsToDelete.emplace_back(entity, typeId);
 		}						  
 
 
 		template <typename C>
-		void forMatchingEntities(std::function<void (Entity*, C*)> callback) {
+		void forMatchingEntities(std::function<void (Entity*, ComponentPointer<C>)> callback) {
 			auto componentController = getComponentController<C>();
+			RV_ECS_TRACE_SCOPE("Domain::forMatchingEntities", typeid(C).name());
+			RV_ECS_STATISTICS(auto queryStatistics = recordQuery<C>());
+			RV_ECS_STATISTICS_TIMER(&queryStatistics->nanoseconds);
+			RV_ECS_STATISTICS(auto userCallback = callback; callback = [&](Entity* entity, ComponentPointer<C> component) {
+				queryStatistics->numMatches++;
+				userCallback(entity, component);
+			});
 			componentController->forMatchingEntities(callback);
 		}
 
 
 		template <typename ... C, typename Func>
 		void forMatchingEntities(Func callback) {
-			
+			RV_ECS_TRACE_SCOPE("Domain::forMatchingEntities", typeid(std::tuple<C...>).name());
+			RV_ECS_STATISTICS(auto queryStatistics = recordQuery<C...>());
+			RV_ECS_STATISTICS_TIMER(&queryStatistics->nanoseconds);
+
 			// TODO: Store signature across queries (no need to create new each query)
-			Signature signature(ComponentTypeRegistry::getNumTypes());
-			addComponentTypeToSignature<C...>(signature);
-			
-			signatures.forMatchingSignatures(signature, [this, &callback](unsigned int signatureIndex) {
-				Entity* entity = this->signatureIndexEntityMap.find(signatureIndex)->second;
-				callback(entity, getEntityComponent<C>(entity)...);
+			Signature signature(numSignatureBits);
+			if( !addComponentTypeToSignature<C...>(signature) )
+				return; // No entity can have a component type which the Domain hasn't used
+
+			/*	Matches are processed in batches, and the lookups of a batch are done in stages: each stage reads
+				what the previous stage prefetched for the whole batch (the Entity objects, then the entities'
+				entries in the controllers' slot arrays, then the components), so the lookups of different
+				matches don't wait for each other. Matched entities have cleaned components, so the pointers stay
+				valid while the callbacks make changes. */
+			auto controllers = std::make_tuple(getComponentController<C>()...);
+			unsigned int batchSignatureIndices[QUERY_BATCH_SIZE];
+			Entity* batchEntities[QUERY_BATCH_SIZE];
+			unsigned int batchSlots[QUERY_BATCH_SIZE];
+			std::tuple<ComponentPointer<C>...> batchComponents[QUERY_BATCH_SIZE];
+			unsigned int batchSize = 0;
+
+			auto processBatch = [&]() {
+				for( unsigned int i = 0; i < batchSize; i++ ) {
+					batchEntities[i] = signatures.getEntity(batchSignatureIndices[i]);
+					RV_ECS_PREFETCH(batchEntities[i]);
+				}
+
+				for( unsigned int i = 0; i < batchSize; i++ ) {
+					batchSlots[i] = getEntitySlot(batchEntities[i]);
+					std::apply([&](auto ... controller) { (controller->prefetchSlot(batchSlots[i]), ...); }, controllers);
+				}
+
+				for( unsigned int i = 0; i < batchSize; i++ ) {
+					batchComponents[i] = std::apply([&](auto ... controller) { return std::make_tuple(controller->getCleanedComponent(batchSlots[i])...); }, controllers);
+					std::apply([](auto& ... components) { (prefetchComponent(components), ...); }, batchComponents[i]);
+				}
+
+				for( unsigned int i = 0; i < batchSize; i++ )
+					std::apply([&](auto& ... components) { callback(batchEntities[i], components...); }, batchComponents[i]);
+
+				RV_ECS_STATISTICS(queryStatistics->numMatches += batchSize);
+				batchSize = 0;
+			};
+
+			signatures.forMatchingSignatures(signature, [&](unsigned int signatureIndex) {
+				batchSignatureIndices[batchSize++] = signatureIndex;
+				if( batchSize == QUERY_BATCH_SIZE )
+					processBatch();
+			});
+			processBatch();
+		}
+
+
+		/**
+		 * @brief	Finds the entities which have all of the component types, and returns them as a range of
+		 *			(Entity*, C&...) tuples. The view is valid until the Domain is cleaned (see View).
+		 *
+		 * @details	The matches are stored in the frame arena, which is reset when the Domain is cleaned, so
+		 *			creating views doesn't allocate from the Domain's memory resource in steady state.
+		*/
+		template <typename ... C>
+		View<C...> view() {
+			RV_ECS_TRACE_SCOPE("Domain::view", typeid(std::tuple<C...>).name());
+			RV_ECS_STATISTICS(auto queryStatistics = recordQuery<C...>());
+			RV_ECS_STATISTICS_TIMER(&queryStatistics->nanoseconds);
+
+			View<C...> view(&frameArena);
+
+			Signature signature(numSignatureBits);
+			if( !addComponentTypeToSignature<C...>(signature) )
+				return view; // No entity can have a component type which the Domain hasn't used
+
+			// No more entities can match than the number of components of the least used type (reserving keeps
+			// the match lists from leaving their outgrown memory in the arena)
+			view.reserve(std::min({ (size_t)getComponentController<C>()->getNumComponents()... }));
+
+			signatures.forMatchingSignatures(signature, [&](unsigned int signatureIndex) {
+				Entity* entity = signatures.getEntity(signatureIndex);
+				view.addMatch(entity, getEntityComponent<C>(entity)...);
 			});
+
+			RV_ECS_STATISTICS(queryStatistics->numMatches += (unsigned int)view.size());
+			return view;
+		}
+
+
+		/**
+		 * @brief	Calls the callback for each chunk of the entities which have all of the component types, with the
+		 *			entities and their components as raw arrays: callback(Entity* const* entities, size_t count, C* ... components).
+		 *			See View::forEachChunk().
+		 * @param alignment	If not 0, chunks are split so most of them start at components aligned to this number of bytes
+		*/
+		template <typename ... C, typename Func>
+		void forEachChunk(Func callback, size_t alignment = 0) {
+			RV_ECS_TRACE_SCOPE("Domain::forEachChunk", typeid(std::tuple<C...>).name());
+			view<C...>().forEachChunk(callback, alignment);
 		}
 
 		/*template <typename T>
@@ -106,6 +308,82 @@ namespace River::ECS {
 		unsigned int getNumEntities();
 
 
+		/**
+		 * @brief	Calls the callback for each "cleaned" Entity (same set of entities as counted by getNumEntities())
+		 * @param callback	The callback to call
+		*/
+		void forEachEntity(std::function<void(Entity*)> callback);
+
+
+		/**
+		 * @brief	Records a write to the Entity's component data in the Domain's ChangeTrackers (writes aren't
+		 *			detected on their own). Does nothing if the Domain has no trackers.
+		*/
+		void markEntityChanged(Entity* entity);
+
+
+		/**
+		 * @brief	Throws DomainNotCleanException if there are changes that haven't been cleaned
+		 * @param operation	Description of the operation which requires the Domain to be cleaned
+		*/
+		void checkClean(const std::string& operation);
+
+
+		/**
+		 * @brief	Stores a copy of the Domain's entities and components in the snapshot, which can later be
+					restored with restore(). The snapshot's memory is reused between calls, so reusing one snapshot
+					object is cheaper than creating a new one.
+		 *
+		 * @details	The Domain must be cleaned. Destroyed entities are kept in memory (but not in the Domain) while
+					a stored snapshot refers to them, so restoring a snapshot brings back the same Entity pointers.
+					They're deleted once no snapshot refers to them (i.e. when the snapshot is stored again).
+		 * @param snapshot	Snapshot created for this Domain
+		*/
+		void snapshot(DomainSnapshot& snapshot);
+
+
+		/**
+		 * @brief	Restores the Domain to the state stored in the snapshot. Changes which haven't been cleaned
+					are discarded, and entities created after the snapshot are destroyed immediately (their
+					EntityIds will be handed out again).
+		 *
+		 * @param snapshot	Snapshot created for this Domain, which has been stored with snapshot()
+		*/
+		void restore(const DomainSnapshot& snapshot);
+
+
+		/**
+		 * @brief	Creates an independent copy of the Domain, with new Entity objects (with the same EntityIds)
+		 *			and copies of all components. The Domain must be cleaned.
+		 * @return	The new Domain, which is owned by the caller
+		*/
+		Domain* clone();
+
+
+		/**
+		 * @return	Statistics of the last frame (from the end of the clean before the last one, to the end of the
+		 *			last clean). Statistics are only collected if RV_ECS_ENABLE_STATISTICS is defined.
+		*/
+		const DomainStatistics& getStatistics() const {
+			return statistics;
+		}
+
+
+		/**
+		 * @return	Used and reserved bytes of each of the Domain's structures, and of each component type's structures.
+		 *			Hash map sizes are estimates, and the overhead of the memory resource isn't included.
+		*/
+		MemoryReport memoryReport() const;
+
+
+		/**
+		 * @return	Number of component types the Domain has used, which is the number of bits in its signatures
+		*/
+		unsigned int getNumComponentTypes() const {
+			return numSignatureBits;
+		}
+
+
 		
 	private:
 		template <typename C>
@@ -119,61 +397,219 @@ namespace River::ECS {
 				return (ComponentController<C>*) controllerIterator->second;
 
 			// Component Type isn't registered yet, so it's registered and then returned
-			auto emplaceResult = componentControllers.emplace(componentTypeId, new ComponentController<C>());
+			auto emplaceResult = componentControllers.emplace(componentTypeId, new ComponentController<C>(memoryResource));
+			addSignatureBit(componentTypeId, emplaceResult.first->second);
+			RV_ECS_STATISTICS(recordComponentType(componentTypeId, emplaceResult.first->second, typeid(C).name()));
 			return (ComponentController<C>*) emplaceResult.first->second;
 		}
 
 
+		/**
+		 * @brief	Constructs a new Entity in the Domain's memory
+		*/
+		Entity* allocateEntity(EntityId id);
+
+		/**
+		 * @brief	Constructs a new Entity with the given slot, which the caller has taken out of the free slots
+		*/
+		Entity* allocateEntity(EntityId id, unsigned int slot);
+
+		void deallocateEntity(Entity* entity);
+
+		/**
+		 * @brief	Empties the lists of changes to clean, and frees their memory in the frame arena
+		*/
+		void clearChanges();
+
+		/**
+		 * @brief	Records the changes which are being cleaned in the ChangeTrackers
+		*/
+		void trackChanges();
+
+		/**
+		 * @brief	Deletes the entity, or keeps it as a retired entity if a snapshot refers to it
+		*/
+		void retireEntity(Entity* entity);
+
+		/**
+		 * @brief	Adds a snapshot reference to each of the entities
+		*/
+		void referenceEntities(const std::pmr::vector<Entity*>& entities);
+
+		/**
+		 * @brief	Removes a snapshot reference from each of the entities, and deletes the retired entities which
+		 *			are no longer referenced by any snapshot
+		*/
+		void releaseEntities(const std::pmr::vector<Entity*>& entities);
+
+		/**
+		 * @brief	Called by DomainSnapshot on destruction. Releases the snapshot's entities.
+		*/
+		void releaseSnapshot(DomainSnapshot& snapshot);
+
+		/**
+		 * @brief	Makes the controller record its statistics into the frame's statistics
+		*/
+		void recordComponentType(ComponentTypeId typeId, IComponentController* controller, const std::string& name);
+
+		/**
+		 * @brief	Counts a query of the component types in the frame's statistics
+		 * @return	The statistics to record the query's matches and time in
+		*/
+		template <typename ... C>
+		QueryStatistics* recordQuery() {
+			auto& queryStatistics = frameStatistics.queries[{ ComponentTypeRegistry::getTypeId<C>()... }];
+			queryStatistics.numQueries++;
+			return &queryStatistics;
+		}
+
+		/**
+		 * @brief	Stores the statistics of the frame which ended with the clean, and starts a new frame
+		*/
+		void endStatisticsFrame();
+
+
+		/**
+		 * @brief	Sets the signature bits of the component types
+		 * @return	False if the Domain hasn't used one of the types (so it doesn't have a signature bit)
+		*/
 		template <typename C>
-		void addComponentTypeToSignature(Signature& signature) {
+		bool addComponentTypeToSignature(Signature& signature) {
 			RV_ECS_ASSERT_COMPONENT_TYPE(C);
 
-			// The given Component type may not have been registered in the system yet
-			// so this is basically to check that, and resize the Signature in
-			// case the Component is new.
-			auto typeId = ComponentTypeRegistry::getTypeId<C>();
-			if( signature.getSize() <= typeId )
-				signature.resize(typeId+1);
+			auto signatureBit = getSignatureBit(ComponentTypeRegistry::getTypeId<C>());
+			if( signatureBit == NO_SIGNATURE_BIT )
+				return false;
 
-			signature.set(ComponentTypeRegistry::getTypeId<C>());
+			signature.set(signatureBit);
+			return true;
 		}
 
 		template <typename CFirst, typename CSecond, typename ... CRest>
-		void addComponentTypeToSignature(Signature& signature) {
-			addComponentTypeToSignature<CFirst>(signature);
-			addComponentTypeToSignature<CSecond, CRest...>(signature);
+		bool addComponentTypeToSignature(Signature& signature) {
+			return addComponentTypeToSignature<CFirst>(signature) && addComponentTypeToSignature<CSecond, CRest...>(signature);
 		}
 
 
+		/**
+		 * @return	The component type's bit in the Domain's signatures, or NO_SIGNATURE_BIT if the Domain hasn't used the type
+		*/
+		unsigned int getSignatureBit(ComponentTypeId typeId) const {
+			return typeId < typeSignatureBits.size() ? typeSignatureBits[typeId] : NO_SIGNATURE_BIT;
+		}
+
+		/**
+		 * @brief	Gives the component type the next signature bit
+		*/
+		void addSignatureBit(ComponentTypeId typeId, IComponentController* controller);
+
+		/**
+		 * @brief	Adds the controller of the signature bit to the controllers to clean (if it hasn't been added)
+		*/
+		void markControllerDirty(unsigned int signatureBit);
+
+		/**
+		 * @brief	Adds the entity to the entities whose component of the signature bit's type is deleted on clean
+		*/
+		void addComponentDeletion(unsigned int signatureBit, Entity* entity);
+
+
 	private:
-		// TODO: Change this to unordered_set
-		std::vector<Entity*> entities;
+		DomainSettings settings;
 
 		/**
-		 * @brief Maps an Entity to its index into the 'entities' vector */
-		std::unordered_map<Entity*, unsigned int> entityIndices;
+		 * @brief The Domain's own arena (if enabled in the settings). Declared before any container using it. */
+		std::unique_ptr<std::pmr::unsynchronized_pool_resource> arena;
 
-		std::unordered_set<Entity*> newEntities;
-		std::unordered_set<Entity*> entitiesToDelete;
+		/**
+		 * @brief Resource which all memory is allocated from (either the arena or the resource from the settings) */
+		std::pmr::memory_resource* memoryResource;
 
 		/**
-		 * @brief Maps an entity to an index into the signature array */
-		std::unordered_map<Entity*, unsigned int> entitySignatureIndexMap;
+		 * @brief Memory for the lists of changes to clean, which is reset at the end of each clean */
+		FrameArena frameArena;
+
+		std::pmr::vector<Entity*> newEntities;
 
 		/**
-		 * @brief Maps an signature index to an entiy */
-		std::unordered_map<unsigned int, Entity*> signatureIndexEntityMap; // TODO: use vector instead
+		 * @brief Entities to delete (may contain duplicates, which are removed when cleaning) */
+		std::pmr::vector<Entity*> entitiesToDelete;
 
+		std::pmr::vector<std::pair<Entity*, ComponentTypeId>> entityComponentsToCreate;
+		std::pmr::vector<std::pair<Entity*, ComponentTypeId>> entityComponentsToDelete;
 
-		std::unordered_map<Entity*, std::vector<ComponentTypeId>> entityComponentsToCreate;
-		std::unordered_map<Entity*, std::vector<ComponentTypeId>> entityComponentsToDelete;
-		
+		EntityId nextEntityId = NULL_ENTITY_ID + 1;
 
+		/**
+		 * @brief The cleaned entities (in order of creation) */
+		std::pmr::vector<Entity*> entities;
 
+		/**
+		 * @brief Signatures of the cleaned entities, which also map a signature index to its Entity (each Entity
+		 *			stores the index of its signature) */
 		SignatureArray signatures;
 
-		std::unordered_map<ComponentTypeId, IComponentController*> componentControllers;
+		inline static const unsigned int NO_SIGNATURE_BIT = std::numeric_limits<unsigned int>::max();
+
+		/**
+		 * @brief Number of matches whose entities and components are looked up together in multi-component queries */
+		inline static const unsigned int QUERY_BATCH_SIZE = 64;
+
+		/**
+		 * @brief Maps a ComponentTypeId to the type's bit in the signatures. Bits are only given to the types which the
+		 *			Domain uses (in order of first use), so the signatures are only as wide as the Domain needs. */
+		std::pmr::vector<unsigned int> typeSignatureBits;
+
+		unsigned int numSignatureBits = 0;
+
+		/**
+		 * @brief The controller of each signature bit's component type */
+		std::pmr::vector<IComponentController*> signatureBitControllers;
+
+		/**
+		 * @brief Signature bits of the controllers which have changes to clean (in the frame arena) */
+		std::pmr::vector<unsigned int> dirtyControllers;
+
+		/**
+		 * @brief Whether the controller of each signature bit is in dirtyControllers (in the frame arena) */
+		std::pmr::vector<bool> dirtyControllerFlags;
+
+		/**
+		 * @brief Entities whose component of each signature bit's type is deleted on clean (in the frame arena) */
+		std::pmr::vector<std::pmr::vector<Entity*>> componentDeletions;
+
+		std::pmr::unordered_map<ComponentTypeId, IComponentController*> componentControllers;
+
+		/**
+		 * @brief Destroyed entities, which are kept alive because a stored snapshot may restore them */
+		std::pmr::unordered_set<Entity*> retiredEntities;
+
+		/**
+		 * @brief Slots of deleted Entity objects, which are reused by new entities (see Entity::slot) */
+		std::pmr::vector<unsigned int> freeEntitySlots;
+
+		/**
+		 * @brief Number of slots handed out to Entity objects (including the free slots) */
+		unsigned int numEntitySlots = 0;
+
+		/**
+		 * @brief The trackers which record the Domain's changes (added and removed by the trackers themselves) */
+		std::pmr::vector<ChangeTracker*> changeTrackers;
+
+		/**
+		 * @brief Statistics of the current frame, which controllers record into */
+		DomainStatistics frameStatistics;
+
+		/**
+		 * @brief Statistics of the last completed frame */
+		DomainStatistics statistics;
+
+		/**
+		 * @brief Incremented when the Domain is cleaned or restored, which invalidates its ComponentRefs */
+		unsigned int cleanEpoch = 0;
 
+		friend class DomainSnapshot;
+		friend class ChangeTracker;
 	};
 
 }
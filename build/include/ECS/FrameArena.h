@@ -0,0 +1,82 @@
+#pragma once
+
+#include <memory_resource>
+#include <cstddef>
+
+
+namespace River::ECS {
+
+	/**
+	 * @brief	Bump allocator for memory which only lives until the next reset() (i.e. the next Domain clean).
+	 *			Deallocation does nothing; all memory is freed at once by reset().
+	 *
+	 * @details	Allocations are served from a single block. If a frame needs more memory than the block holds,
+	 *			the overflowing allocations are taken from the upstream resource, and the block is grown to fit
+	 *			the entire frame on the next reset. This means that frames which don't use more memory than a
+	 *			previous frame don't allocate from the upstream resource.
+	*/
+	class FrameArena : public std::pmr::memory_resource {
+	public:
+
+		/**
+		 * @param initialSize	Initial size of the block in bytes
+		 * @param upstream		Resource which the block and overflowing allocations are taken from
+		*/
+		FrameArena(size_t initialSize, std::pmr::memory_resource* upstream = std::pmr::get_default_resource());
+		~FrameArena();
+
+
+		/**
+		 * @brief	Frees all memory allocated since the last reset. All pointers allocated from the arena are invalidated.
+		*/
+		void reset();
+
+
+		/**
+		 * @return	Size of the block in bytes
+		*/
+		size_t getCapacity() const {
+			return capacity;
+		}
+
+
+		/**
+		 * @return	Number of bytes allocated since the last reset (including overflowing allocations)
+		*/
+		size_t getBytesAllocated() const {
+			return bytesAllocated;
+		}
+
+
+	private:
+		FrameArena(const FrameArena&) = delete;
+		FrameArena& operator=(const FrameArena&) = delete;
+
+		void* do_allocate(size_t bytes, size_t alignment) override;
+		void do_deallocate(void* p, size_t bytes, size_t alignment) override;
+		bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override;
+
+
+	private:
+
+		/**
+		 * @brief Header in front of each overflowing allocation, linking it to the previous one */
+		struct Overflow {
+			Overflow* previous;
+			void* memory;
+			size_t size;
+			size_t alignment;
+		};
+
+		std::pmr::memory_resource* upstream;
+
+		unsigned char* block = nullptr;
+		size_t capacity = 0;
+		size_t offset = 0;
+
+		size_t bytesAllocated = 0;
+
+		Overflow* lastOverflow = nullptr;
+	};
+
+}
@@ -0,0 +1,25 @@
+#pragma once
+
+#include <ostream>
+#include <string>
+
+
+namespace River::ECS {
+
+	/**
+	 * @brief	Writes the string as a JSON string literal
+	*/
+	inline void writeJsonString(std::ostream& stream, const std::string& string) {
+		stream << '"';
+		for( char c : string ) {
+			if( c == '"' || c == '\\' )
+				stream << '\\' << c;
+			else if( (unsigned char)c < 0x20 )
+				stream << ' ';
+			else
+				stream << c;
+		}
+		stream << '"';
+	}
+
+}
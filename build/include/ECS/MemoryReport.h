@@ -0,0 +1,82 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <map>
+
+#include "Component.h"
+
+
+namespace River::ECS {
+
+	/**
+	 * @brief	Memory of a data structure. Used bytes are the bytes of the stored elements, and reserved bytes
+	 *			are all bytes allocated for the structure (including unused capacity and per-element overhead).
+	*/
+	struct MemoryUsage {
+		size_t usedBytes = 0;
+		size_t reservedBytes = 0;
+
+		MemoryUsage& operator+=(const MemoryUsage& other) {
+			usedBytes += other.usedBytes;
+			reservedBytes += other.reservedBytes;
+			return *this;
+		}
+	};
+
+
+	/**
+	 * @return	Memory of the vector's elements
+	*/
+	template <typename Vector>
+	MemoryUsage getVectorMemoryUsage(const Vector& vector) {
+		using T = typename Vector::value_type;
+		return { vector.size() * sizeof(T), vector.capacity() * sizeof(T) };
+	}
+
+
+	/**
+	 * @return	Estimated memory of the unordered map/set. Each element is assumed to be a node with two
+	 *			pointers, and each bucket a pointer (the exact overhead depends on the standard library).
+	*/
+	template <typename HashTable>
+	MemoryUsage getHashTableMemoryUsage(const HashTable& table) {
+		using T = typename HashTable::value_type;
+		size_t nodeSize = sizeof(T) + 2 * sizeof(void*);
+		return { table.size() * sizeof(T), table.size() * nodeSize + table.bucket_count() * sizeof(void*) };
+	}
+
+
+	/**
+	 * @brief Memory of named data structures */
+	using MemoryStructures = std::map<std::string, MemoryUsage>;
+
+
+	struct ComponentTypeMemoryReport {
+		std::string name;
+
+		/**
+		 * @brief Memory of each of the component controller's structures */
+		MemoryStructures structures;
+
+		MemoryUsage getTotal() const;
+	};
+
+
+	/**
+	 * @brief	Memory used by a Domain, split into its own structures and the structures of each component type
+	*/
+	struct MemoryReport {
+		MemoryStructures structures;
+
+		std::map<ComponentTypeId, ComponentTypeMemoryReport> componentTypes;
+
+		MemoryUsage getTotal() const;
+
+		/**
+		 * @return	The report as a JSON object
+		*/
+		std::string toJson() const;
+	};
+
+}
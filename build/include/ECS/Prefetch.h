@@ -0,0 +1,35 @@
+#pragma once
+
+#include "ComponentFields.h"
+
+
+/*	Hints the CPU to load the cache line at the address into the cache, so it's there when it's read later.
+	Compiles to nothing if the compiler has no prefetch intrinsic. */
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#include <xmmintrin.h>
+#define RV_ECS_PREFETCH(address) _mm_prefetch((const char*)(address), _MM_HINT_T0)
+#elif defined(__GNUC__) || defined(__clang__)
+#define RV_ECS_PREFETCH(address) __builtin_prefetch(address)
+#else
+#define RV_ECS_PREFETCH(address)
+#endif
+
+
+namespace River::ECS {
+
+	/**
+	 * @brief	Prefetches the component (does nothing for null pointers)
+	*/
+	template <typename C>
+	void prefetchComponent(C* component) {
+		if( component != nullptr )
+			RV_ECS_PREFETCH(component);
+	}
+
+	/**
+	 * @brief	Does nothing, as the fields of a structure of arrays component are in different arrays
+	*/
+	template <typename C>
+	void prefetchComponent(const ComponentFieldsRef<C>&) {}
+
+}
@@ -0,0 +1,68 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+#include "ECS/Exception.h"
+#include "ECS/ByteWriter.h"
+
+
+namespace River::ECS {
+
+	// Thrown if a delta buffer is truncated or otherwise malformed
+	class DeltaFormatException : public Exception {
+	public:
+		DeltaFormatException(const std::string& message) : Exception("Malformed delta: " + message) {}
+	};
+
+
+	/**
+	 * @brief	Reads values written by a ByteWriter
+	*/
+	class ByteReader {
+	public:
+
+		ByteReader(const unsigned char* data, size_t size) : data(data), size(size) {}
+
+
+		uint64_t readVarUInt() {
+			uint64_t value = 0;
+			unsigned int shift = 0;
+			while( true ) {
+				if( position >= size )
+					throw DeltaFormatException("unexpected end of data");
+				if( shift >= 64 )
+					throw DeltaFormatException("varint is too long");
+
+				unsigned char byte = data[position++];
+				value |= (uint64_t)(byte & 0x7F) << shift;
+				if( (byte & 0x80) == 0 ) return value;
+				shift += 7;
+			}
+		}
+
+
+		/**
+		 * @return	Pointer to the next 'numBytes' bytes, which are then skipped
+		*/
+		const unsigned char* readBytes(size_t numBytes) {
+			if( numBytes > size - position )
+				throw DeltaFormatException("unexpected end of data");
+			const unsigned char* bytes = data + position;
+			position += numBytes;
+			return bytes;
+		}
+
+
+		bool isAtEnd() const {
+			return position == size;
+		}
+
+
+	private:
+		const unsigned char* data;
+		size_t size;
+		size_t position = 0;
+	};
+
+}
@@ -0,0 +1,105 @@
+#pragma once
+
+#include <vector>
+#include <memory>
+
+#include "ECS/ChangeTracker.h"
+#include "ReplicatedType.h"
+#include "Snapshot.h"
+#include "SnapshotHistory.h"
+
+
+namespace River::ECS {
+
+	/**
+	 * @brief	Encodes the replicated state of a Domain as a delta against a previously encoded tick (the baseline),
+	 *			containing only created/destroyed entities, changed masks and changed component bytes.
+	 *
+	 * @details	The encoder tracks the Domain's changes with a ChangeTracker, and only reads the entities which have
+	 *			changed since the last encode. Writes to component data must therefore be marked with
+	 *			Entity::markChanged(), or they aren't replicated. The whole Domain is only read by the first encode,
+	 *			and after the Domain has been restored to a DomainSnapshot.
+	 *
+	 *			The encoder keeps the current replicated state, and the previous state of the entities changed in each
+	 *			encoded tick, until the tick is dropped by acknowledge(). The Domain must be cleaned before encoding,
+	 *			and the encoder must be destroyed before the Domain.
+	 *
+	 *			Format (all integers are varints, see ByteWriter):
+	 *				tick, baselineTick + 1 (0 if no baseline)
+	 *				numDestroyed, EntityId...
+	 *				numCreated, EntityId...
+	 *				numRecords, and for each record:
+	 *					EntityId, mask, dataMask
+	 *					for each type in dataMask: runs of (numZeroBytes, numLiteralBytes, literal bytes...)
+	 *					covering the component's bytes XOR'ed with the baseline's bytes
+	*/
+	class DeltaEncoder {
+	public:
+
+		DeltaEncoder() {}
+
+
+		/**
+		 * @brief	Registers a component type for replication. All types must be added before the first encode.
+		 * @tparam C	Component type, which must be trivially copyable (or have its fields listed with
+		 *				RV_ECS_REPLICATED_FIELDS)
+		*/
+		template <typename C>
+		void addComponentType() {
+			if( history != nullptr )
+				throw Exception("Component types must be added before encoding");
+			types.add<C>();
+		}
+
+
+		/**
+		 * @brief	Updates the encoder's state of the Domain as the given tick, and encodes the difference from the
+		 *			baseline tick
+		 * @param tick			Tick to encode, which must not be older than the previously encoded tick
+		 * @param baselineTick	A previously encoded tick which the receiver has acknowledged, or Snapshot::NO_TICK to encode
+		 *						the full state. If the baseline has been dropped, the full state is encoded.
+		 * @return	The encoded delta
+		*/
+		std::vector<unsigned char> encode(Domain& domain, unsigned int tick, unsigned int baselineTick = Snapshot::NO_TICK);
+
+
+		/**
+		 * @brief	Drops the changes of all ticks older than the given tick, as these will no longer be used as baseline
+		*/
+		void acknowledge(unsigned int tick);
+
+
+		/**
+		 * @return	Number of ticks which can currently be used as baseline
+		*/
+		unsigned int getNumSnapshots();
+
+
+	private:
+		DeltaEncoder(const DeltaEncoder&) = delete;
+		DeltaEncoder& operator=(const DeltaEncoder&) = delete;
+
+		/**
+		 * @brief	Updates the current state from the changes of the Domain as the given tick
+		*/
+		void update(Domain& domain, unsigned int tick);
+
+		/**
+		 * @brief	Reads the Entity's replicated components, and updates its state in the history
+		*/
+		void updateEntity(Entity* entity);
+
+
+	private:
+		ReplicatedTypeSet types;
+
+		std::unique_ptr<SnapshotHistory> history;
+
+		std::unique_ptr<ChangeTracker> tracker;
+
+		/**
+		 * @brief Holds a single entity, which components are read into before they're compared with the current state */
+		std::unique_ptr<Snapshot> readBuffer;
+	};
+
+}
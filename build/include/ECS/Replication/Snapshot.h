@@ -0,0 +1,124 @@
+#pragma once
+
+#include <vector>
+#include <unordered_map>
+#include <cstdint>
+#include <limits>
+
+#include "ECS/Domain.h"
+
+
+namespace River::ECS {
+
+	/**
+	 * @brief	Copy of the replicated state of a Domain at a given tick: which entities exist, which replicated
+	 *			component types each of them has (its mask), and the bytes of those components.
+	 *
+	 * @details	Component data is stored densely per component type, indexed by the entity's index in the
+	 *			snapshot. Data of components an entity doesn't have is always zero, which is what deltas of
+	 *			newly added components are XOR'ed against.
+	*/
+	class Snapshot {
+	public:
+
+		// A mask has one bit per replicated component type
+		const static unsigned int MAX_TYPES = 64;
+
+		// Tick value used when there is no snapshot (i.e. a delta without baseline)
+		const static unsigned int NO_TICK = std::numeric_limits<unsigned int>::max();
+
+		/**
+		 * @param dataSizes		Number of bytes per component of each replicated type
+		*/
+		Snapshot(unsigned int tick, const std::vector<unsigned int>& dataSizes);
+
+
+		/**
+		 * @brief	Adds an entity with no components
+		 * @return	The index of the entity in the snapshot
+		*/
+		unsigned int addEntity(EntityId id);
+
+		/**
+		 * @brief	Removes the entity, moving the last entity in the snapshot into its index
+		*/
+		void removeEntity(EntityId id);
+
+		/**
+		 * @return	Index of the entity in the snapshot, or -1 if the snapshot doesn't contain it
+		*/
+		int findEntity(EntityId id) const;
+
+
+		/**
+		 * @brief	Sets the entity's mask. Data of components which are removed by the new mask is zeroed.
+		*/
+		void setMask(unsigned int entityIndex, uint64_t mask);
+
+		/**
+		 * @brief	Copies the mask and component data of an entity in another snapshot (with the same types) into the entity
+		*/
+		void copyEntity(unsigned int entityIndex, const Snapshot& source, unsigned int sourceIndex);
+
+		/**
+		 * @return	Whether the entity has the same mask and component data as an entity in another snapshot
+		*/
+		bool equalsEntity(unsigned int entityIndex, const Snapshot& source, unsigned int sourceIndex) const;
+
+
+		uint64_t getMask(unsigned int entityIndex) const {
+			return masks[entityIndex];
+		}
+
+		unsigned char* getData(unsigned int entityIndex, unsigned int typeIndex) {
+			return data[typeIndex].data() + (size_t)entityIndex * dataSizes[typeIndex];
+		}
+
+		const unsigned char* getData(unsigned int entityIndex, unsigned int typeIndex) const {
+			return data[typeIndex].data() + (size_t)entityIndex * dataSizes[typeIndex];
+		}
+
+		unsigned int getDataSize(unsigned int typeIndex) const {
+			return dataSizes[typeIndex];
+		}
+
+		EntityId getEntityId(unsigned int entityIndex) const {
+			return entityIds[entityIndex];
+		}
+
+		unsigned int getNumEntities() const {
+			return (unsigned int)entityIds.size();
+		}
+
+		unsigned int getNumTypes() const {
+			return (unsigned int)dataSizes.size();
+		}
+
+		unsigned int getTick() const {
+			return tick;
+		}
+
+		void setTick(unsigned int newTick) {
+			tick = newTick;
+		}
+
+
+	private:
+		unsigned int tick;
+
+		std::vector<unsigned int> dataSizes;
+
+		std::vector<EntityId> entityIds;
+
+		/**
+		 * @brief Maps an EntityId to its index in the snapshot */
+		std::unordered_map<EntityId, unsigned int> entityIndices;
+
+		std::vector<uint64_t> masks;
+
+		/**
+		 * @brief Component data of each type, dataSizes[type] bytes per entity */
+		std::vector<std::vector<unsigned char>> data;
+	};
+
+}
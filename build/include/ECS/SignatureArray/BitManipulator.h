@@ -2,8 +2,10 @@
 
 #include <string>
 #include <functional>
+#include <vector>
 
 #include "ECS/Exception.h"
+#include "BitOperations.h"
 
 namespace River::ECS {
 
@@ -12,6 +14,11 @@ namespace River::ECS {
 	 *
 	 * @details The class doesn't create the data, but is being passed the data from the creator
 				of the object.
+
+				The first and last set bit, and the number of bits set, are updated whenever a bit is set
+				or unset, so reading them is constant time. To find the next first/last bit when these are
+				unset, the manipulator keeps a summary with a bit for each 64-bit word of the data, which is
+				set if the word has any bits set.
 	*/
 	class BitManipulator {
 	public:
@@ -29,12 +36,24 @@ namespace River::ECS {
 
 
 		/**
-		 * @brief	Sets the data the BitManipulator is supposed to operate on
+		 * @brief	Sets the data the BitManipulator is supposed to operate on. This scans the data
+					to find the bits which are set.
 		 * @param data	Pointer to array of data
 		 * @param numBits	Number of bits to manipulate in the dat
 		*/
 		void setData(unsigned char* data, unsigned int numBits);
 
+		/**
+		 * @brief	Updates the data pointer, after the data has been moved (the contents must be the same)
+		*/
+		void setDataPointer(unsigned char* data);
+
+		/**
+		 * @brief	Changes the number of bits to manipulate, without scanning the data. Bits added must
+					be unset in the data, and bits removed must have been unset.
+		*/
+		void setNumBits(unsigned int numBits);
+
 		/**
 		 * @return	Whether or not the i'th bit is set 
 		*/
@@ -50,6 +69,28 @@ namespace River::ECS {
 		*/
 		void unset(unsigned int i);
 
+		/**
+		 * @brief	Same as get(), but without checking that the index is in range
+		*/
+		bool getUnchecked(unsigned int i) const {
+			return (bits[i >> 3] >> (i & 7)) & 1;
+		}
+
+		/**
+		 * @brief	Same as set(), but without checking that the index is in range
+		*/
+		void setUnchecked(unsigned int i);
+
+		/**
+		 * @brief	Same as unset(), but without checking that the index is in range
+		*/
+		void unsetUnchecked(unsigned int i);
+
+		/**
+		 * @brief	Overwrites the partIndex'th byte of the data
+		*/
+		void setPart(unsigned int partIndex, unsigned char value);
+
 		/**
 		 * @brief	Unsets all bits (sets all values to 0)
 		*/
@@ -58,17 +99,23 @@ namespace River::ECS {
 		/**
 		 * @return	The index of the first bit which is set, or -1 if no bits are set
 		*/
-		int getFirstSetBit();
+		int getFirstSetBit() const {
+			return firstBit;
+		}
 
 		/**
 		 * @return	The index of the last bit which is set, or -1 if no bits are set
 		*/
-		int getLastSetBit();
+		int getLastSetBit() const {
+			return lastBit;
+		}
 
 		/**
 		 * @return	The number of bits which are set
 		*/
-		unsigned int getBitsSet();
+		unsigned int getBitsSet() const {
+			return bitsSet;
+		}
 
 		/**
 		 * @return	The data (bits) which the manipulator is operation on
@@ -92,24 +139,48 @@ namespace River::ECS {
 	private:
 
 		/**
-		 * @brief	Updates which bit is the last and first set (firstBit and lastBit), as well as the number of bits set (bitsSet)
-					This sets the 'dirty' flag to false.
-		 *
-		 * @details Since this function is relatively slow, it's called only when either of the variables are requested, and not when
-					the values wrong.
+		 * @brief	Finds the first bit, last bit and the number of bits set in the data, and builds the summary
 		*/
 		void checkBits();
 
+		/**
+		 * @brief	Updates the summary bit of the word containing the given part (byte)
+		*/
+		void updateSummary(unsigned int partIndex);
+
+		/**
+		 * @return	Index of the first bit set in the word, or any later word, or -1 if there is none
+		*/
+		int findFirstSetBit(unsigned int wordIndex) const;
+
+		/**
+		 * @return	Index of the last bit set in the word, or any earlier word, or -1 if there is none
+		*/
+		int findLastSetBit(unsigned int wordIndex) const;
+
+		uint64_t* getSummary() {
+			return summaryWords <= 1 ? &inlineSummary : summary.data();
+		}
+
+		const uint64_t* getSummary() const {
+			return summaryWords <= 1 ? &inlineSummary : summary.data();
+		}
+
 
 	protected:
 		unsigned char* bits;
 		unsigned int size;
 		unsigned int parts;
 
-		bool dirty = false;
 		unsigned int bitsSet = 0;
 		int firstBit = -1;
 		int lastBit = -1;
+
+		/**
+		 * @brief Summary of which words have bits set. Kept in inlineSummary if it fits in one word (data of up to 4096 bits) */
+		std::vector<uint64_t> summary;
+		uint64_t inlineSummary = 0;
+		unsigned int summaryWords = 0;
 	};
 
 }
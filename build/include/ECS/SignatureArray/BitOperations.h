@@ -0,0 +1,79 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+
+namespace River::ECS::BitOperations {
+
+	/*	Bits are stored as arrays of bytes, where bit i is in byte i/8. These are loaded as 64-bit
+		little-endian words, so bit i of the array is bit i%64 of word i/64. */
+
+
+	/**
+	 * @return	Number of bits set in the word
+	*/
+	inline unsigned int countSetBits(uint64_t word) {
+	#if defined(_MSC_VER)
+		return (unsigned int)__popcnt64(word);
+	#else
+		return (unsigned int)__builtin_popcountll(word);
+	#endif
+	}
+
+
+	/**
+	 * @return	Index of the lowest bit set in the word (the word must not be 0)
+	*/
+	inline unsigned int countTrailingZeros(uint64_t word) {
+	#if defined(_MSC_VER)
+		unsigned long index;
+		_BitScanForward64(&index, word);
+		return (unsigned int)index;
+	#else
+		return (unsigned int)__builtin_ctzll(word);
+	#endif
+	}
+
+
+	/**
+	 * @return	Index of the highest bit set in the word (the word must not be 0)
+	*/
+	inline unsigned int highestSetBit(uint64_t word) {
+	#if defined(_MSC_VER)
+		unsigned long index;
+		_BitScanReverse64(&index, word);
+		return (unsigned int)index;
+	#else
+		return 63 - (unsigned int)__builtin_clzll(word);
+	#endif
+	}
+
+
+	/**
+	 * @brief	Reads the wordIndex'th word of a byte array with the given number of bytes. Bytes past
+	 *			the end of the array are read as 0.
+	*/
+	inline uint64_t loadWord(const unsigned char* bytes, unsigned int numBytes, unsigned int wordIndex) {
+		unsigned int offset = wordIndex * 8;
+		uint64_t word = 0;
+		if( offset + 8 <= numBytes )
+			std::memcpy(&word, bytes + offset, 8);
+		else
+			std::memcpy(&word, bytes + offset, numBytes - offset);
+		return word;
+	}
+
+
+	/**
+	 * @return	Number of words needed to hold the given number of bytes
+	*/
+	inline unsigned int numWords(unsigned int numBytes) {
+		return (numBytes + 7) / 8;
+	}
+
+}
@@ -4,8 +4,10 @@
 #include <unordered_map>
 #include <functional>
 #include <sstream>
+#include <memory_resource>
 
 #include "Signature.h"
+#include "ECS/MemoryReport.h"
 
 
 namespace River::ECS {
@@ -18,13 +20,46 @@ namespace River::ECS {
 
 
 
+	/**
+	 * @brief	How the signatures of a SignatureArray are stored
+	*/
+	enum class SignatureLayout {
+		/**
+		 * @brief	Each signature's bits are stored contiguously (as well as in the columns), so the bits set in
+		 *			a signature can be found without checking every column. Increasing the signature size may
+		 *			require moving all signatures. */
+		RowMajor,
+
+		/**
+		 * @brief	Signatures are only stored in the columns, so increasing the signature size only adds
+		 *			new columns, and removing a signature moves one bit per column. */
+		ColumnMajor
+	};
+
+
+	/**
+	 * @brief	Array of equally sized signatures
+	 *
+	 * @details	The array keeps a column bitmap for each signature bit, with one bit per signature. Each
+	 *			column has a summary with one bit per 64 signatures (block), which is set if any of the
+	 *			block's signatures has the bit set. Queries AND the columns of the bits they require, and
+	 *			skip blocks where any of the columns' summary bits are unset.
+	 *
+	 *			With the RowMajor layout, the signatures are also stored row by row. Queries only read the
+	 *			columns, but the operations on a single signature (remove() and forEachSetBit()) read its row,
+	 *			so they take time proportional to the bits set in it, instead of the number of columns. This
+	 *			costs a second copy of the bits, so ColumnMajor is the better choice when memory matters more
+	 *			than destroying entities with few of many component types.
+	*/
 	class SignatureArray {
 	public:
 
 		/**
-		 * @param numSignaturesReserved	Number of signatures to reserve memory for at on creation
+		 * @param initialMemorySize	Number of bytes to reserve on creation. Memory is never shrunk below this automatically.
+		 * @param memoryResource	Resource which the array's memory is allocated from
+		 * @param layout			How the signatures are stored
 		*/
-		SignatureArray(unsigned int initialMemorySize);
+		SignatureArray(unsigned int initialMemorySize, std::pmr::memory_resource* memoryResource = std::pmr::get_default_resource(), SignatureLayout layout = SignatureLayout::RowMajor);
 		~SignatureArray();
 
 		/**
@@ -37,6 +72,9 @@ namespace River::ECS {
 
 		/**
 		 * @brief Checks if each signature in the array matches the given signature, and call the callback function in case it does
+		 *
+		 * @details	Signatures are visited in order of their index. Only blocks of 64 signatures where all of the
+		 *			queried bits are set in some signature are checked.
 		 * @param signature
 		 * @param callback
 		*/
@@ -48,18 +86,55 @@ namespace River::ECS {
 		void unsetSignatureBit(unsigned int signatureIndex, unsigned int bitIndex);
 		void unsetAllSignatureBit(unsigned int signatureIndex, unsigned int bitIndex);
 
+		/**
+		 * @brief	Calls the callback with the index of each bit set in the signature, in increasing order
+		*/
+		void forEachSetBit(unsigned int signatureIndex, std::function<void(unsigned int bitIndex)> callback);
 
+
+		/**
+		 * @brief	Sets the number of bits in each signature (it can't be reduced). If the signatures' capacity
+		 *			can't hold the new size, the capacity is doubled (rounded up to whole words), which moves all
+		 *			signatures with the RowMajor layout.
+		*/
 		void setSignatureSize(unsigned int newSignatureSize);
 
+		/**
+		 * @brief	Reserves room for the given number of bits in each signature, so setSignatureSize() doesn't
+		 *			have to move the signatures until the size exceeds this.
+		*/
+		void reserveSignatureSize(unsigned int numBits);
+
+		/**
+		 * @return	Number of bits each signature has room for
+		*/
+		unsigned int getSignatureCapacity();
+
 		/**
 		 * @brief Adds a new signature to the array, where all bits are set to 0
+		 * @param entity	The Entity which the signature belongs to
 		 * @return	The index of the signature, which
 		*/
-		unsigned int add();
+		unsigned int add(Entity* entity = nullptr);
+
+
+		/**
+		 * @return	The Entity of the signature at the index
+		*/
+		Entity* getEntity(unsigned int signatureIndex) const {
+			return entities[signatureIndex];
+		}
+
+		/**
+		 * @brief	Sets the Entity of the signature at the index
+		*/
+		void setEntity(unsigned int signatureIndex, Entity* entity) {
+			entities[signatureIndex] = entity;
+		}
 
 
 		/**
-		 * @brief	Removes the signature on the given index, and moves the last signature in the array to this index
+		 * @brief	Removes the signature (and its Entity) on the given index, and moves the last signature in the array to this index
 		 * @param signatureIndex	Index of the signature to remove (this index should have been returned by the add() method)
 		 * @return	Index of the signature which was moved to the removed signatures slot (before it was removed), or 0
 					if no signature was moved (because removed was either last element in list, or the only element)
@@ -69,14 +144,17 @@ namespace River::ECS {
 
 		/**
 		 * @brief Allocate enough space to hold the given number of signatures. If the memory required for this is
-		 *			less than currently reserved memory, this function will do nothing.
+		 *			less than currently reserved memory, this function will do nothing. Otherwise the memory is at
+		 *			least doubled.
+		 *
+		 * @details	Memory is automatically shrunk when signatures are removed, and less than a quarter of it is used.
 		 * @param numSignatures		Number of signatures to reserver memory for
 		*/
 		void reserveSignatures(unsigned int numSignatures);
 
 		/**
 		 * @brief	Allocate enough memory to hold the given number of bytes. If the currently reserved memory
-					is larger than this, the functill will do nothing.
+					is larger than this, the functill will do nothing. Only used by the RowMajor layout.
 
 		 * @param memory	Number of bytes to reserver
 		*/
@@ -85,17 +163,61 @@ namespace River::ECS {
 
 
 
+		/**
+		 * @brief	Overwrites this array's signatures with a copy of the other array's signatures, and takes
+					its layout. Memory is only reallocated if this array hasn't reserved enough memory to hold them.
+					The rows, columns and entities are copied as blocks, without looking at the bits.
+		*/
+		void copyFrom(const SignatureArray& other);
+
+
+		/**
+		 * @brief	Frees all memory which isn't used by the current signatures
+		*/
+		void shrinkToFit();
+
+
+		/**
+		 * @return	Number of times the memory has been grown (rows and columns count as one each)
+		*/
+		unsigned int getNumGrowths();
+
+		/**
+		 * @return	Number of times the memory has been shrunk, either automatically or by shrinkToFit()
+		*/
+		unsigned int getNumShrinks();
+
 		/**
 		 * @return	Number of signatures (not the reserved number)
 		*/
-		unsigned int getNumSignatures();
+		unsigned int getNumSignatures() const;
 
 		
 		/**
-		 * @return	Number of bytes this array has reserved
+		 * @return	Number of bytes this array has reserved for rows (0 with the ColumnMajor layout)
 		*/
 		unsigned int getMemorySize();
 
+		/**
+		 * @return	Memory of the rows (RowMajor layout)
+		*/
+		MemoryUsage getRowMemoryUsage() const;
+
+		/**
+		 * @return	Memory of the column bitmaps and their summaries
+		*/
+		MemoryUsage getColumnMemoryUsage() const;
+
+		/**
+		 * @return	Memory of the signatures' entities
+		*/
+		MemoryUsage getEntityMemoryUsage() const;
+
+
+		SignatureLayout getLayout() const {
+			return layout;
+		}
+
 
 
 	private:
@@ -114,9 +236,56 @@ namespace River::ECS {
 		bool checkCachedQuery(Signature& signature, std::function<void(unsigned int signatureIndex)> callback);
 
 
+		/**
+		 * @brief	Sets or unsets the signature's bit in the column of the given bit index
+		*/
+		void setColumnBit(unsigned int bitIndex, unsigned int signatureIndex);
+		void unsetColumnBit(unsigned int bitIndex, unsigned int signatureIndex);
+		bool getColumnBit(unsigned int bitIndex, unsigned int signatureIndex) const;
+
+		/**
+		 * @brief	Moves each signature (RowMajor layout) so it takes up the given number of parts
+		*/
+		void resizeRows(unsigned int newSignatureParts);
+
+		/**
+		 * @brief	Grows the columns so they have a bit for each signature
+		*/
+		void reserveColumns();
+
+		/**
+		 * @brief	Removes column words past the last signature
+		*/
+		void trimColumns();
+
+		/**
+		 * @brief	Makes sure the columns have room for the given number of words (at least doubling the capacity)
+		*/
+		void reserveColumnCapacity(unsigned int words);
+
+		/**
+		 * @brief	Reallocates the columns' memory to hold exactly the given number of words
+		*/
+		void resizeColumnCapacity(unsigned int words);
+
+		/**
+		 * @brief	Shrinks the memory if less than a quarter of it is used
+		*/
+		void shrinkIfUnused();
+
+		/**
+		 * @brief	Moves the rows to newly allocated memory of the given size
+		*/
+		void reallocate(unsigned int bytes);
+
+
 
 	private:
 
+		std::pmr::memory_resource* memoryResource;
+
+		SignatureLayout layout;
+
 		unsigned int memoryStepSize = 0;
 
 		/**
@@ -126,18 +295,41 @@ namespace River::ECS {
 		unsigned int numSignatures = 0;
 
 		unsigned int signatureSize = 0; // TODO: Fix this
-		unsigned int signatureParts = 1; // Number of unsigned chars to represent elements (always elementSize ceil(elementSize/sizeof(unsigned char))
+		unsigned int signatureParts = 8; // Number of unsigned chars each signature takes up (whole words, and at least enough to hold signatureSize bits)
 
 		unsigned char* data = nullptr;
 
-		// Maps signature to index to Entity
-		std::unordered_map<unsigned int, River::ECS::Entity*> entityMap; // TODO: Change to vector (faster lookup)
+		/**
+		 * @brief The Entity of each signature (moved along with the signatures) */
+		std::pmr::vector<Entity*> entities;
+
 
-		// Maps Entity to signature index
-		std::unordered_map<River::ECS::Entity*, unsigned int> indexMap;
+		struct Column {
+			Column(std::pmr::memory_resource* memoryResource) : signatures(memoryResource), blocks(memoryResource) {}
+
+			/**
+			 * @brief Bit per signature, set if the signature has the column's bit set */
+			std::pmr::vector<uint64_t> signatures;
+
+			/**
+			 * @brief Bit per word in 'signatures', set if the word is not 0 */
+			std::pmr::vector<uint64_t> blocks;
+		};
 
+		/**
+		 * @brief Column for each bit in the signatures */
+		std::pmr::vector<Column> columns;
+
+		/**
+		 * @brief Number of words in each column's 'signatures' */
+		unsigned int columnWords = 0;
+
+		/**
+		 * @brief Number of words each column has reserved memory for */
+		unsigned int columnCapacity = 0;
 
-		BitManipulator bitManipulator = BitManipulator(nullptr, 0);
+		unsigned int numGrowths = 0;
+		unsigned int numShrinks = 0;
 
 
 		
@@ -0,0 +1,411 @@
+#pragma once
+
+#include <array>
+#include <tuple>
+#include <deque>
+#include <vector>
+#include <limits>
+#include <cstdint>
+#include <type_traits>
+#include <memory_resource>
+
+#include "Component.h"
+#include "ComponentController.h"
+#include "Domain.h"
+
+
+namespace River::ECS {
+
+	// Thrown if an EntityId doesn't refer to an entity in the StaticDomain
+	class InvalidEntityException : public Exception {
+	public:
+		InvalidEntityException(EntityId id) : Exception("Entity " + std::to_string(id) + " doesn't exist in the Domain") {}
+	};
+
+
+	/**
+	 * @brief	Index of the type T in the list of types
+	*/
+	template <typename T, typename ... Types>
+	struct TypeIndex {
+		static_assert(sizeof(T) == 0, "Component type is not one of the StaticDomain's component types");
+	};
+
+	template <typename T, typename ... Rest>
+	struct TypeIndex<T, T, Rest...> : std::integral_constant<unsigned int, 0> {};
+
+	template <typename T, typename First, typename ... Rest>
+	struct TypeIndex<T, First, Rest...> : std::integral_constant<unsigned int, 1 + TypeIndex<T, Rest...>::value> {};
+
+
+
+	/**
+	 * @brief	Storage of a single component type in a StaticDomain
+	*/
+	template <typename C>
+	struct StaticComponentStorage {
+		RV_ECS_ASSERT_COMPONENT_TYPE(C);
+
+		/**
+		 * @brief Flag on indices into newComponents (rather than components) */
+		inline static const unsigned int NEW_COMPONENT = 1u << 31;
+		inline static const unsigned int NO_COMPONENT = std::numeric_limits<unsigned int>::max();
+
+		StaticComponentStorage(std::pmr::memory_resource* memoryResource) :
+			components(memoryResource),
+			componentEntities(memoryResource),
+			newComponents(memoryResource),
+			newComponentEntities(memoryResource),
+			indices(memoryResource)
+		{}
+
+		/**
+		 * @brief Cleaned components, without gaps */
+		std::pmr::vector<C> components;
+		std::pmr::vector<EntityId> componentEntities;
+
+		/**
+		 * @brief Components added since the last clean (a deque, so pointers stay valid until the clean) */
+		std::pmr::deque<C> newComponents;
+		std::pmr::vector<EntityId> newComponentEntities;
+
+		/**
+		 * @brief Maps an EntityId to the index of its component (NEW_COMPONENT is set if it's in newComponents) */
+		std::pmr::vector<unsigned int> indices;
+
+
+		C* get(EntityId entity) {
+			if( entity >= indices.size() ) return nullptr;
+			unsigned int index = indices[entity];
+			if( index == NO_COMPONENT ) return nullptr;
+			if( index & NEW_COMPONENT ) return &newComponents[index & ~NEW_COMPONENT];
+			return &components[index];
+		}
+
+
+		C* add(EntityId entity) {
+			if( indices.size() <= entity )
+				indices.resize(entity + 1, NO_COMPONENT);
+			if( indices[entity] != NO_COMPONENT )
+				throw MultipleComponentException(typeid(C).name());
+
+			indices[entity] = (unsigned int)newComponents.size() | NEW_COMPONENT;
+			newComponentEntities.push_back(entity);
+			return &newComponents.emplace_back();
+		}
+
+
+		/**
+		 * @brief	Moves the new components to the end of the cleaned components
+		*/
+		void moveNewComponents() {
+			for( size_t i = 0; i < newComponents.size(); i++ ) {
+				indices[newComponentEntities[i]] = (unsigned int)components.size();
+				components.push_back(std::move(newComponents[i]));
+				componentEntities.push_back(newComponentEntities[i]);
+			}
+			newComponents.clear();
+			newComponentEntities.clear();
+		}
+
+
+		/**
+		 * @brief	Removes the entity's cleaned component (if it has one), moving the last component into its place
+		*/
+		void remove(EntityId entity) {
+			if( entity >= indices.size() || indices[entity] == NO_COMPONENT ) return;
+			unsigned int index = indices[entity];
+			indices[entity] = NO_COMPONENT;
+
+			unsigned int last = (unsigned int)components.size() - 1;
+			if( index != last ) {
+				components[index] = std::move(components[last]);
+				componentEntities[index] = componentEntities[last];
+				indices[componentEntities[index]] = index;
+			}
+			components.pop_back();
+			componentEntities.pop_back();
+		}
+	};
+
+
+
+	/**
+	 * @brief	Domain with a fixed set of component types, known at compile time
+	 *
+	 * @details	Type indices, the signature width and query masks are resolved at compile time, and each
+	 *			component type has its own storage (without virtual calls or type lookups). Queries loop over
+	 *			the entities' signatures, and compare them with a constant mask.
+	 *
+	 *			Entities are identified by their EntityId. Like the Domain, changes take effect when the
+	 *			StaticDomain is cleaned: new entities and components aren't matched by queries before, and
+	 *			removed components and destroyed entities stay until then. EntityIds of destroyed entities are
+	 *			reused after the clean.
+	 *
+	 * @tparam C	The component types (each must inherit from ECS::Component)
+	*/
+	template <typename ... C>
+	class StaticDomain {
+		static_assert(sizeof...(C) > 0, "StaticDomain must have at least one component type");
+
+		/**
+		 * @brief Row of an entity which hasn't been cleaned yet */
+		inline static const unsigned int NO_ROW = std::numeric_limits<unsigned int>::max();
+
+		/**
+		 * @brief Row of an EntityId which isn't in use */
+		inline static const unsigned int FREE_ENTITY = NO_ROW - 1;
+
+	public:
+
+		static constexpr unsigned int NUM_COMPONENT_TYPES = sizeof...(C);
+		static constexpr unsigned int NUM_SIGNATURE_WORDS = (NUM_COMPONENT_TYPES + 63) / 64;
+
+		using Signature = std::array<uint64_t, NUM_SIGNATURE_WORDS>;
+
+
+		/**
+		 * @return	The index of the component type, which is its bit in the signatures
+		*/
+		template <typename T>
+		static constexpr unsigned int getTypeIndex() {
+			return TypeIndex<T, C...>::value;
+		}
+
+
+		/**
+		 * @return	Signature with the bits of the component types set
+		*/
+		template <typename ... Q>
+		static constexpr Signature getMask() {
+			Signature mask{};
+			((mask[getTypeIndex<Q>() / 64] |= (uint64_t)1 << (getTypeIndex<Q>() % 64)), ...);
+			return mask;
+		}
+
+
+
+		StaticDomain(std::pmr::memory_resource* memoryResource = std::pmr::get_default_resource()) :
+			storages(MemoryResourceOf<C>(memoryResource)...),
+			signatures(memoryResource),
+			rowEntities(memoryResource),
+			entityRows(memoryResource),
+			freeEntityIds(memoryResource),
+			newEntities(memoryResource),
+			entitiesToDestroy(memoryResource),
+			componentsToAdd(memoryResource),
+			componentsToRemove(memoryResource)
+		{
+			entityRows.push_back(FREE_ENTITY); // NULL_ENTITY_ID
+		}
+
+
+		EntityId createEntity() {
+			EntityId entity;
+			if( freeEntityIds.empty() ) {
+				entity = (EntityId)entityRows.size();
+				entityRows.push_back(NO_ROW);
+			} else {
+				entity = freeEntityIds.back();
+				freeEntityIds.pop_back();
+				entityRows[entity] = NO_ROW;
+			}
+			newEntities.push_back(entity);
+			return entity;
+		}
+
+
+		/**
+		 * @brief	Marks the entity for destruction on the next clean
+		*/
+		void destroyEntity(EntityId entity) {
+			checkEntity(entity);
+			entitiesToDestroy.push_back(entity);
+		}
+
+
+		template <typename T>
+		T* addComponent(EntityId entity) {
+			checkEntity(entity);
+			auto component = getStorage<T>().add(entity);
+			componentsToAdd.push_back({ entity, getTypeIndex<T>() });
+			return component;
+		}
+
+
+		/**
+		 * @return	Temporary pointer to the entity's component (valid until the next clean), or nullptr if it doesn't have it
+		*/
+		template <typename T>
+		T* getComponent(EntityId entity) {
+			return getStorage<T>().get(entity);
+		}
+
+
+		/**
+		 * @brief	Marks the component for removal on the next clean
+		*/
+		template <typename T>
+		void removeComponent(EntityId entity) {
+			checkEntity(entity);
+			componentsToRemove.push_back({ entity, getTypeIndex<T>() });
+		}
+
+
+		/**
+		 * @brief	Calls the callback for each cleaned entity with all of the component types Q
+		 * @param callback	Called with the EntityId and a pointer to each of the components
+		*/
+		template <typename ... Q, typename Func>
+		void forMatchingEntities(Func callback) {
+			static constexpr Signature mask = getMask<Q...>();
+			for( unsigned int row = 0; row < signatures.size(); row++ ) {
+				if( !matches(signatures[row], mask) ) continue;
+				EntityId entity = rowEntities[row];
+				callback(entity, getCleanComponent<Q>(entity)...);
+			}
+		}
+
+
+		/**
+		 * @brief	Applies the changes since the last clean: adds new entities and components, and removes
+		 *			removed components and destroyed entities. Invalidates all component pointers.
+		*/
+		void clean() {
+			for( auto entity : newEntities ) {
+				entityRows[entity] = (unsigned int)signatures.size();
+				signatures.push_back(Signature{});
+				rowEntities.push_back(entity);
+			}
+
+			(getStorage<C>().moveNewComponents(), ...);
+			for( auto& change : componentsToAdd )
+				setBit(signatures[entityRows[change.first]], change.second, true);
+
+			for( auto& change : componentsToRemove ) {
+				auto& signature = signatures[entityRows[change.first]];
+				if( !getBit(signature, change.second) ) continue;
+				setBit(signature, change.second, false);
+				removeComponentOfType(change.first, change.second);
+			}
+
+			for( auto entity : entitiesToDestroy ) {
+				unsigned int row = entityRows[entity];
+				if( row == FREE_ENTITY ) continue; // Destroyed twice
+
+				(getStorage<C>().remove(entity), ...);
+
+				unsigned int last = (unsigned int)signatures.size() - 1;
+				if( row != last ) {
+					signatures[row] = signatures[last];
+					rowEntities[row] = rowEntities[last];
+					entityRows[rowEntities[row]] = row;
+				}
+				signatures.pop_back();
+				rowEntities.pop_back();
+
+				entityRows[entity] = FREE_ENTITY;
+				freeEntityIds.push_back(entity);
+			}
+
+			newEntities.clear();
+			entitiesToDestroy.clear();
+			componentsToAdd.clear();
+			componentsToRemove.clear();
+		}
+
+
+		/**
+		 * @return	Number of cleaned entities
+		*/
+		unsigned int getNumEntities() const {
+			return (unsigned int)signatures.size();
+		}
+
+
+
+	private:
+		StaticDomain(const StaticDomain&) = delete;
+		StaticDomain& operator=(const StaticDomain&) = delete;
+
+		template <typename>
+		using MemoryResourceOf = std::pmr::memory_resource*;
+
+
+		template <typename T>
+		StaticComponentStorage<T>& getStorage() {
+			return std::get<getTypeIndex<T>()>(storages);
+		}
+
+
+		/**
+		 * @brief	Gets the component of a matched entity (which is always cleaned)
+		*/
+		template <typename T>
+		T* getCleanComponent(EntityId entity) {
+			auto& storage = getStorage<T>();
+			return &storage.components[storage.indices[entity]];
+		}
+
+
+		/**
+		 * @brief	Removes the component of the type with the given index
+		*/
+		void removeComponentOfType(EntityId entity, unsigned int typeIndex) {
+			unsigned int index = 0;
+			((index++ == typeIndex ? getStorage<C>().remove(entity) : (void)0), ...);
+		}
+
+
+		void checkEntity(EntityId entity) const {
+			if( entity >= entityRows.size() || entityRows[entity] == FREE_ENTITY )
+				throw InvalidEntityException(entity);
+		}
+
+
+		static bool matches(const Signature& signature, const Signature& mask) {
+			for( unsigned int i = 0; i < NUM_SIGNATURE_WORDS; i++ ) {
+				if( (signature[i] & mask[i]) != mask[i] )
+					return false;
+			}
+			return true;
+		}
+
+		static bool getBit(const Signature& signature, unsigned int bit) {
+			return (signature[bit / 64] >> (bit % 64)) & 1;
+		}
+
+		static void setBit(Signature& signature, unsigned int bit, bool value) {
+			if( value )
+				signature[bit / 64] |= (uint64_t)1 << (bit % 64);
+			else
+				signature[bit / 64] &= ~((uint64_t)1 << (bit % 64));
+		}
+
+
+	private:
+		std::tuple<StaticComponentStorage<C>...> storages;
+
+		/**
+		 * @brief Signature of each cleaned entity (rows without gaps) */
+		std::pmr::vector<Signature> signatures;
+		std::pmr::vector<EntityId> rowEntities;
+
+		/**
+		 * @brief Maps an EntityId to its row, NO_ROW if it isn't cleaned, or FREE_ENTITY if it isn't in use */
+		std::pmr::vector<unsigned int> entityRows;
+
+		/**
+		 * @brief EntityIds of destroyed entities, which are reused */
+		std::pmr::vector<EntityId> freeEntityIds;
+
+		std::pmr::vector<EntityId> newEntities;
+		std::pmr::vector<EntityId> entitiesToDestroy;
+
+		/**
+		 * @brief Entity and type index of the components added/removed since the last clean */
+		std::pmr::vector<std::pair<EntityId, unsigned int>> componentsToAdd;
+		std::pmr::vector<std::pair<EntityId, unsigned int>> componentsToRemove;
+	};
+
+}
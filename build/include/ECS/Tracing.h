@@ -0,0 +1,123 @@
+#pragma once
+
+#include <cstdint>
+#include <ostream>
+#include <functional>
+
+
+/*	Trace events are only recorded if RV_ECS_ENABLE_TRACING is defined (for both the library and the
+	code using it). Otherwise the macros below compile to nothing.
+
+	RV_ECS_TRACE_SCOPE(name, detail) records an event from where it's declared to the end of the
+	scope. The name and the detail (optional) must be string literals, or otherwise outlive the trace. */
+#ifdef RV_ECS_ENABLE_TRACING
+#define RV_ECS_TRACE(...) __VA_ARGS__
+#define RV_ECS_TRACE_SCOPE(...) River::ECS::TraceScope RV_ECS_TRACE_CONCAT(traceScope, __LINE__)(__VA_ARGS__)
+#else
+#define RV_ECS_TRACE(...)
+#define RV_ECS_TRACE_SCOPE(...)
+#endif
+
+#define RV_ECS_TRACE_CONCAT_INNER(a, b) a##b
+#define RV_ECS_TRACE_CONCAT(a, b) RV_ECS_TRACE_CONCAT_INNER(a, b)
+
+
+namespace River::ECS {
+
+	struct TraceEvent {
+		const char* name;
+
+		/**
+		 * @brief Extra information about the event (i.e. the component type), or nullptr */
+		const char* detail;
+
+		/**
+		 * @brief Nanoseconds since the first trace event */
+		uint64_t start;
+
+		uint64_t duration;
+	};
+
+
+	/**
+	 * @brief	Collects trace events from all threads, and writes them as Chrome trace JSON or Perfetto
+	 *			protobuf, which can be opened in chrome://tracing or ui.perfetto.dev.
+	 *
+	 * @details	Each thread records into its own ring buffer without locking, so when a buffer is full, the
+	 *			thread's oldest events are overwritten. Reading the events (forEachEvent, the writers and clear)
+	 *			must not happen while other threads are recording, i.e. it should be done between frames.
+	*/
+	class Tracing {
+	public:
+
+		/**
+		 * @brief Number of events kept per thread */
+		inline static const unsigned int BUFFER_CAPACITY = 16384;
+
+
+		/**
+		 * @return	Nanoseconds since the first trace event (or the first call to now())
+		*/
+		static uint64_t now();
+
+		/**
+		 * @brief	Records the event in the calling thread's buffer
+		*/
+		static void record(const char* name, const char* detail, uint64_t start, uint64_t end);
+
+		/**
+		 * @brief	Calls the callback for each recorded event, with the index of the thread which recorded
+		 *			it. Events of a thread are ordered by the time they ended.
+		*/
+		static void forEachEvent(std::function<void(unsigned int threadIndex, const TraceEvent&)> callback);
+
+		/**
+		 * @brief	Removes all recorded events
+		*/
+		static void clear();
+
+		/**
+		 * @brief	Writes the recorded events in the Chrome trace event JSON format
+		*/
+		static void writeChromeTrace(std::ostream& stream);
+
+		/**
+		 * @brief	Writes the recorded events as a Perfetto trace (binary protobuf, so the stream should
+		 *			be opened in binary mode)
+		*/
+		static void writePerfettoTrace(std::ostream& stream);
+	};
+
+
+	/**
+	 * @brief	Records a trace event from its construction to its destruction
+	*/
+	class TraceScope {
+	public:
+		TraceScope(const char* name, const char* detail = nullptr) : name(name), detail(detail), start(Tracing::now()) {}
+
+		~TraceScope() {
+			Tracing::record(name, detail, start, Tracing::now());
+		}
+
+		/**
+		 * @brief	Ends the current event, and starts a new one with the given name
+		*/
+		void next(const char* nextName, const char* nextDetail = nullptr) {
+			auto now = Tracing::now();
+			Tracing::record(name, detail, start, now);
+			name = nextName;
+			detail = nextDetail;
+			start = now;
+		}
+
+	private:
+		TraceScope(const TraceScope&) = delete;
+		TraceScope& operator=(const TraceScope&) = delete;
+
+		const char* name;
+		const char* detail;
+		uint64_t start;
+	};
+
+}
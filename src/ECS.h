@@ -2,4 +2,5 @@
 
 #include "ECS/Domain.h"
 #include "ECS/Entity.h"
-#include "ECS/Component.h"
\ No newline at end of file
+#include "ECS/Component.h"
+#include "ECS/StaticDomain.h"
\ No newline at end of file
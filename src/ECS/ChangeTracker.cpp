@@ -0,0 +1,50 @@
+#include "ChangeTracker.h"
+
+#include "Entity.h"
+
+
+namespace River::ECS {
+
+	ChangeTracker::ChangeTracker(Domain& domain) :
+		domain(domain),
+		changedEntities(domain.memoryResource),
+		destroyedEntities(domain.memoryResource)
+	{
+		domain.changeTrackers.push_back(this);
+	}
+
+
+	ChangeTracker::~ChangeTracker() {
+		auto& trackers = domain.changeTrackers;
+		trackers.erase(std::remove(trackers.begin(), trackers.end(), this), trackers.end());
+	}
+
+
+	void ChangeTracker::reset() {
+		changedEntities.clear();
+		destroyedEntities.clear();
+		allChanged = false;
+	}
+
+
+	void ChangeTracker::addChanged(Entity* entity) {
+		if( !allChanged )
+			changedEntities.insert(entity);
+	}
+
+
+	void ChangeTracker::addDestroyed(Entity* entity) {
+		if( allChanged ) return;
+		// The entity's memory may be reused, so it's only kept by its id
+		changedEntities.erase(entity);
+		destroyedEntities.push_back(entity->getId());
+	}
+
+
+	void ChangeTracker::setAllChanged() {
+		changedEntities.clear();
+		destroyedEntities.clear();
+		allChanged = true;
+	}
+
+}
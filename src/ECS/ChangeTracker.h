@@ -0,0 +1,91 @@
+#pragma once
+
+#include <vector>
+#include <unordered_set>
+
+#include "Domain.h"
+
+
+namespace River::ECS {
+
+	/**
+	 * @brief	Collects which of a Domain's entities have changed since the last reset(), so that consumers of the
+	 *			Domain's state (like a DeltaEncoder) only have to look at those entities.
+	 *
+	 * @details	Created entities and added/removed components are recorded when the Domain is cleaned. Writes to
+	 *			component data are only recorded if they are marked with Entity::markChanged(). Restoring a
+	 *			DomainSnapshot changes an unknown set of entities, so it marks all entities as changed.
+	 *
+	 *			The tracker must be destroyed before its Domain.
+	*/
+	class ChangeTracker {
+	public:
+
+		/**
+		 * @param domain	The Domain to track the changes of
+		*/
+		ChangeTracker(Domain& domain);
+		~ChangeTracker();
+
+
+		Domain& getDomain() const {
+			return domain;
+		}
+
+
+		/**
+		 * @return	Entities which have been created, have had components added or removed, or have been marked as
+		 *			changed since the last reset (doesn't contain destroyed entities)
+		*/
+		const std::pmr::unordered_set<Entity*>& getChangedEntities() const {
+			return changedEntities;
+		}
+
+
+		/**
+		 * @return	Ids of the entities which have been destroyed since the last reset
+		*/
+		const std::pmr::vector<EntityId>& getDestroyedEntities() const {
+			return destroyedEntities;
+		}
+
+
+		/**
+		 * @return	Whether any entity may have changed since the last reset (if so, the changed and destroyed
+		 *			entities are empty)
+		*/
+		bool isAllChanged() const {
+			return allChanged;
+		}
+
+
+		/**
+		 * @brief	Forgets all changes
+		*/
+		void reset();
+
+
+	private:
+		ChangeTracker(const ChangeTracker&) = delete;
+		ChangeTracker& operator=(const ChangeTracker&) = delete;
+
+		void addChanged(Entity* entity);
+
+		void addDestroyed(Entity* entity);
+
+		void setAllChanged();
+
+
+	private:
+		Domain& domain;
+
+		std::pmr::unordered_set<Entity*> changedEntities;
+
+		std::pmr::vector<EntityId> destroyedEntities;
+
+		bool allChanged = false;
+
+		friend class Domain;
+	};
+
+}
@@ -1,19 +1,33 @@
 #pragma once
 
 #include <vector>
-#include <unordered_map>
 #include <string>
 #include <limits>
 #include <type_traits>
 #include <functional>
+#include <cstring>
+#include <algorithm>
+#include <memory_resource>
+#include <typeinfo>
 
 #include "Component.h"
+#include "ComponentFields.h"
 #include "Exception.h"
+#include "Statistics.h"
+#include "Tracing.h"
+#include "MemoryReport.h"
+#include "Prefetch.h"
 
 
 
 namespace River::ECS {
 	struct Entity;
+	template <typename C> class ComponentRef;
+
+	/**
+	 * @return	The Entity's slot, which component controllers use to index their arrays (defined in Entity.h)
+	*/
+	inline unsigned int getEntitySlot(const Entity* entity);
 
 	// Thrown if an Entity already has a component
 	class MultipleComponentException : public Exception {
@@ -31,8 +45,59 @@ namespace River::ECS {
 
 	class IComponentController {
 	public:
+		virtual ~IComponentController() {}
 		virtual void deleteComponent(Entity* entity) = 0;
+
+		/**
+		 * @brief	Marks the components of the given entities for deletion (same as deleteComponent() for each entity)
+		*/
+		virtual void deleteEntityComponents(Entity* const* entities, size_t numEntities) = 0;
+
 		virtual void clean() = 0;
+
+		/**
+		 * @brief	Removes all components (including new components and components marked for deletion)
+		*/
+		virtual void clear() = 0;
+
+		/**
+		 * @return	A new controller with a copy of this controller's components and state
+		*/
+		virtual IComponentController* clone() const = 0;
+
+		/**
+		 * @brief	Overwrites this controller's components and state with a copy of the other controller's, reusing this
+		 *			controller's memory where possible
+		 * @param other		Controller of the same component type
+		*/
+		virtual void restore(const IComponentController& other) = 0;
+
+		/**
+		 * @brief	Replaces the entities of the components with the entities in the same slots (the new entities must
+		 *			have the slots of the entities they replace)
+		 * @param entitiesBySlot	The new Entity of each slot
+		*/
+		virtual void remapEntities(const std::vector<Entity*>& entitiesBySlot) = 0;
+
+		/**
+		 * @return	Memory of each of the controller's structures
+		*/
+		virtual ComponentTypeMemoryReport getMemoryReport() const = 0;
+
+		/**
+		 * @brief	Records the cache line layout of the cleaned components into the controller's statistics (if set)
+		*/
+		virtual void recordLayoutStatistics() = 0;
+
+		/**
+		 * @brief	Sets the statistics which the controller records to (only if statistics are enabled)
+		*/
+		void setStatistics(ComponentTypeStatistics* statistics) {
+			this->statistics = statistics;
+		}
+
+	protected:
+		ComponentTypeStatistics* statistics = nullptr;
 	};
 
 
@@ -45,8 +110,30 @@ namespace River::ECS {
 		RV_ECS_ASSERT_COMPONENT_TYPE(C);
 		const static unsigned int SECONDARY_LIST_SIZE = 100;
 
+		inline static const bool IS_SOA = ComponentFields<C>::IS_SOA;
+
+		/**
+		 * @brief The primary list: an array of the components, or an array of each field (see ComponentFields) */
+		using PrimaryList = std::conditional_t<IS_SOA, ComponentFieldArrays<C>, std::vector<C, AlignedAllocator<C, ComponentAlignment<C>::VALUE>>>;
+
 	public:
-		ComponentController() {}
+		/**
+		 * @brief C* or ComponentFieldsRef<C> (if the type is stored as a structure of arrays) */
+		using Pointer = ComponentPointer<C>;
+
+		/**
+		 * @param memoryResource	Resource which all of the controller's memory is allocated from
+		*/
+		ComponentController(std::pmr::memory_resource* memoryResource = std::pmr::get_default_resource()) :
+			memoryResource(memoryResource),
+			entityIndices(memoryResource),
+			componentIndices(memoryResource),
+			componentEntities(memoryResource),
+			freeIds(memoryResource),
+			componentsToDelete(memoryResource),
+			newComponents(memoryResource),
+			components(memoryResource)
+		{}
 
 
 		/**
@@ -65,13 +152,15 @@ namespace River::ECS {
 			if( entity == nullptr )
 				throw std::invalid_argument("Entity pointer cannot be null");
 
-			if( componentMap.find(entity) != componentMap.end() )
+			unsigned int slot = getEntitySlot(entity);
+			if( entityIndices.size() <= slot )
+				entityIndices.resize(slot + 1, NO_INDEX);
+			if( entityIndices[slot] != NO_INDEX )
 				throw MultipleComponentException(typeid(C).name()); // Throw exception
 
-			C* component = allocateComponent();
+			C* component = allocateComponent(entity);
 
-			entityMap[component->id] = entity;
-			componentMap[entity] = component->id;
+			RV_ECS_STATISTICS(if( statistics ) statistics->added++);
 
 			return component;
 		}
@@ -83,10 +172,15 @@ namespace River::ECS {
 					Does nothing if the Entity doesn't the particular component.
 		*/
 		void deleteComponent(Entity* entity) override {
-			auto iterator = componentMap.find(entity);
-			if( iterator == componentMap.end() ) return;
-			if( componentsToDelete.find(iterator->second) == componentsToDelete.end() )
-				componentsToDelete.insert(iterator->second);
+			// Entities marked more than once are skipped when the components are deleted
+			if( getEntityIndex(entity) != NO_INDEX )
+				componentsToDelete.push_back(entity);
+		}
+
+
+		void deleteEntityComponents(Entity* const* entities, size_t numEntities) override {
+			for( size_t i = 0; i < numEntities; i++ )
+				ComponentController::deleteComponent(entities[i]);
 		}
 
 
@@ -95,12 +189,12 @@ namespace River::ECS {
 		 * @return	Temporary to pointer the Entity's component, or nullptr if the Entity doesn't have this component.
 					The pointer is invalidated when the Controller is cleaned or compressed.
 		*/
-		C* getComponent(Entity* entity) {
-			auto iterator = componentMap.find(entity);
-			if( iterator == componentMap.end() )
+		Pointer getComponent(Entity* entity) {
+			unsigned int index = getEntityIndex(entity);
+			if( index == NO_INDEX )
 				return nullptr;
 
-			return getComponent(iterator->second);
+			return getComponentAt(index);
 		}
 
 
@@ -110,27 +204,37 @@ namespace River::ECS {
 		 * @return	Temporary to pointer Component, or nullptr if the the 'id' is not in use.
 					The pointer is invalidated when the Controller is cleaned or compressed.
 		*/
-		C* getComponent(ComponentId id) {
+		Pointer getComponent(ComponentId id) {
 			if( id == NULL_COMPONENT_ID )
 				throw new Exception("ComponentId is null");
 
 			// Check if id exists
-			auto iterator = indexMap.find(id);
-			if( iterator == indexMap.end() )
+			if( id >= componentIndices.size() || componentIndices[id] == NO_INDEX )
 				return nullptr;
 
-			// Find component primary list
-			unsigned int index = iterator->second;
-			unsigned int primaryListSize = (unsigned int)components.size();
-			if( index < primaryListSize )
-				return &components.at(index);
+			return getComponentAt(componentIndices[id]);
+		}
 
-			// Find component in list of new components
-			unsigned int adjustedIndex = (index - primaryListSize);
-			unsigned int listIndex = adjustedIndex / SECONDARY_LIST_SIZE;
-			unsigned int elementIndex = adjustedIndex % SECONDARY_LIST_SIZE;
 
-			return &newComponents.at(listIndex).at(elementIndex);
+		/**
+		 * @brief	Prefetches the component index of the Entity in the slot (see getCleanedComponent())
+		*/
+		void prefetchSlot(unsigned int slot) const {
+			if( slot < entityIndices.size() )
+				RV_ECS_PREFETCH(&entityIndices[slot]);
+		}
+
+
+		/**
+		 * @return	The component of the Entity in the slot, which must have a cleaned component (i.e. its signature
+		 *			has the component type's bit)
+		*/
+		Pointer getCleanedComponent(unsigned int slot) {
+			unsigned int index = entityIndices[slot];
+			if constexpr( IS_SOA )
+				return Pointer(&components, index);
+			else
+				return &components[index];
 		}
 
 
@@ -138,10 +242,13 @@ namespace River::ECS {
 		 * @brief	Call the given callback for each Entity which has this Component
 		 * @param callback	The callback to call
 		*/
-		void forMatchingEntities(std::function<void(Entity*, C*)> callback) {
-			for( auto& component : components ) {
-				auto entity = entityMap.find(component.id)->second;
-				callback(entity, &component);
+		void forMatchingEntities(std::function<void(Entity*, Pointer)> callback) {
+			// The primary list may have unused components at its end (it's never downsized)
+			for( unsigned int i = 0; i < numComponentsInPrimary; i++ ) {
+				if constexpr( IS_SOA )
+					callback(componentEntities[i], Pointer(&components, i));
+				else
+					callback(componentEntities[i], &components[i]);
 			}
 		}
 
@@ -151,11 +258,79 @@ namespace River::ECS {
 		 *			This invalidated all pointers to Components returned by the controller
 		*/
 		void clean() override {
+			RV_ECS_TRACE_SCOPE("ComponentController::clean", typeid(C).name());
 			moveNewComponents();
 			deleteComponents();
 		}
 
 
+		void clear() override {
+			entityIndices.clear();
+			componentIndices.clear();
+			componentEntities.clear();
+			freeIds.clear();
+			componentsToDelete.clear();
+			newComponents.clear();
+			numComponents = 0;
+			numComponentsInPrimary = 0;
+		}
+
+
+		IComponentController* clone() const override {
+			auto controller = new ComponentController<C>(memoryResource);
+			controller->copyFrom(*this);
+			return controller;
+		}
+
+
+		void restore(const IComponentController& other) override {
+			copyFrom(static_cast<const ComponentController<C>&>(other));
+		}
+
+
+		void remapEntities(const std::vector<Entity*>& entitiesBySlot) override {
+			// The slots don't change, so entityIndices stays valid
+			for( auto& entity : componentEntities )
+				entity = entitiesBySlot[getEntitySlot(entity)];
+			for( auto& entity : componentsToDelete )
+				entity = entitiesBySlot[getEntitySlot(entity)];
+		}
+
+
+		ComponentTypeMemoryReport getMemoryReport() const override {
+			ComponentTypeMemoryReport report;
+			report.name = typeid(C).name();
+
+			// The primary list is never downsized, so only the cleaned components are in use
+			if constexpr( IS_SOA )
+				report.structures["components"] = components.getMemoryUsage(numComponentsInPrimary);
+			else
+				report.structures["components"] = { numComponentsInPrimary * sizeof(C), components.capacity() * sizeof(C) };
+
+			auto& newComponentsUsage = report.structures["newComponents"];
+			newComponentsUsage.reservedBytes = newComponents.capacity() * sizeof(newComponents[0]);
+			for( auto& list : newComponents )
+				newComponentsUsage += getVectorMemoryUsage(list);
+
+			report.structures["entityIndices"] = getVectorMemoryUsage(entityIndices);
+			report.structures["componentIndices"] = getVectorMemoryUsage(componentIndices);
+			report.structures["componentEntities"] = getVectorMemoryUsage(componentEntities);
+			report.structures["freeIds"] = getVectorMemoryUsage(freeIds);
+			report.structures["componentsToDelete"] = getVectorMemoryUsage(componentsToDelete);
+			return report;
+		}
+
+
+		void recordLayoutStatistics() override {
+			if( statistics == nullptr ) return;
+			statistics->numComponents = numComponentsInPrimary;
+			if constexpr( IS_SOA )
+				components.recordLayoutStatistics(numComponentsInPrimary, *statistics);
+			else
+				statistics->recordArrayLayout(components.data(), sizeof(C), numComponentsInPrimary);
+		}
+
+
 		/*
 		 * @return	Current number of components
 		*/
@@ -171,37 +346,119 @@ namespace River::ECS {
 		ComponentController& operator=(const ComponentController&) = delete;
 
 		/**
-		 * @brief	Finds the next available component id
+		 * @brief	Copies the other controller's state. The lookup arrays are plain vectors, so they're copied as
+		 *			blocks (like the components).
+		*/
+		void copyFrom(const ComponentController& other) {
+			entityIndices = other.entityIndices;
+			componentIndices = other.componentIndices;
+			componentEntities = other.componentEntities;
+			freeIds = other.freeIds;
+			componentsToDelete = other.componentsToDelete;
+			newComponents = other.newComponents;
+			numComponents = other.numComponents;
+			numComponentsInPrimary = other.numComponentsInPrimary;
+
+			// Only the used part of the primary list is copied (it's never downsized)
+			if( components.size() < other.numComponentsInPrimary )
+				components.resize(other.numComponentsInPrimary);
+
+			if constexpr( IS_SOA ) {
+				components.copyFrom(other.components, numComponentsInPrimary);
+			} else if constexpr( std::is_trivially_copyable<C>::value ) {
+				if( numComponentsInPrimary > 0 )
+					std::memcpy(components.data(), other.components.data(), sizeof(C) * numComponentsInPrimary);
+			} else {
+				std::copy(other.components.begin(), other.components.begin() + numComponentsInPrimary, components.begin());
+			}
+		}
+
+
+		/**
+		 * @return	Index of the Entity's component (new components included), or NO_INDEX if it has none
+		*/
+		unsigned int getEntityIndex(const Entity* entity) const {
+			unsigned int slot = getEntitySlot(entity);
+			return slot < entityIndices.size() ? entityIndices[slot] : NO_INDEX;
+		}
+
+
+		/**
+		 * @return	Pointer to the component at the index, which is either in the primary list or in one of the
+		 *			secondary lists
+		*/
+		Pointer getComponentAt(unsigned int index) {
+			// Find component primary list
+			// The field arrays may have room for more components, but new components are never stored there
+			unsigned int primaryListSize = IS_SOA ? numComponentsInPrimary : (unsigned int)components.size();
+			if( index < primaryListSize ) {
+				if constexpr( IS_SOA )
+					return Pointer(&components, index);
+				else
+					return &components.at(index);
+			}
+
+			// Find component in list of new components
+			unsigned int adjustedIndex = (index - primaryListSize);
+			unsigned int listIndex = adjustedIndex / SECONDARY_LIST_SIZE;
+			unsigned int elementIndex = adjustedIndex % SECONDARY_LIST_SIZE;
+
+			return &newComponents.at(listIndex).at(elementIndex);
+		}
+
+
+		/**
+		 * @return	Id of the cleaned component at the index
+		*/
+		ComponentId getIdAt(unsigned int index) const {
+			if constexpr( IS_SOA )
+				return components.getId(index);
+			else
+				return components[index].id;
+		}
+
+
+		/**
+		 * @brief	Finds the next available component id (reusing the ids of deleted components)
 		*/
 		ComponentId createComponentId() {
 			if( numComponents >= MAX_COMPONENT_ID )
 				throw new MaxComponentsException(typeid(C).name());
 
-			while( indexMap.find(nextId) != indexMap.end() ) {
-				if( nextId == MAX_COMPONENT_ID )
-					nextId = 0;
-				else
-					nextId++;
+			if( !freeIds.empty() ) {
+				ComponentId id = freeIds.back();
+				freeIds.pop_back();
+				return id;
 			}
-			return nextId;
+
+			// NULL_COMPONENT_ID is never handed out
+			if( componentIndices.empty() )
+				componentIndices.push_back(NO_INDEX);
+			componentIndices.push_back(NO_INDEX);
+			return (ComponentId)(componentIndices.size() - 1);
 		}
 
 
 		/**
-		 * @brief	Adds a component with the given ID to the list of new components
+		 * @brief	Adds a component for the Entity to the list of new components
 		 * @return	Pointer to the newly added component
 		*/
-		C* allocateComponent() {
+		C* allocateComponent(Entity* entity) {
 			ComponentId id = createComponentId();
 			unsigned int index = numComponents;
 
 			C* newComponent = nullptr;
 
-			if( components.size() > numComponents ) {
-				newComponent = &components[index];
-				numComponentsInPrimary++;
-				numComponents++;
-			} else {
+			// Components of structure of arrays types are always created in the secondary lists, as the primary
+			// list doesn't store whole components
+			if constexpr( !IS_SOA ) {
+				if( components.size() > numComponents ) {
+					newComponent = &components[index];
+					numComponentsInPrimary++;
+				}
+			}
+
+			if( newComponent == nullptr ) {
 				if( newComponents.size() == 0 || newComponents.back().size() == SECONDARY_LIST_SIZE ) {
 					// All lists are full - create new secondary list
 					// This is to ensure that pointers to other newly created components aren't
@@ -213,13 +470,15 @@ namespace River::ECS {
 				auto& list = newComponents.back();
 				list.emplace_back();
 				newComponent = &list.back();
-				numComponents++;
 			}
+			numComponents++;
 
 
 			(*newComponent) = C(); // Reset to default values
 			newComponent->id = id;
-			indexMap[id] = index;
+			componentIndices[id] = index;
+			entityIndices[getEntitySlot(entity)] = index;
+			componentEntities.push_back(entity);
 
 			return newComponent;
 		}
@@ -233,6 +492,7 @@ namespace River::ECS {
 
 			// Check if there are any components to move
 			if( newComponents.size() == 0 ) return;
+			RV_ECS_STATISTICS_TIMER(statistics ? &statistics->moveNanoseconds : nullptr);
 
 			// Resize primary list (we'll never downsize)
 			if( components.size() < numComponents )
@@ -241,9 +501,12 @@ namespace River::ECS {
 			for( auto& secondaryList : newComponents ) {
 				for( auto& component : secondaryList ) {
 					if( numComponents - numComponentsInPrimary <= 0 ) break;
-					auto& newDestination = components.at(numComponentsInPrimary);
-					newDestination = component;
+					if constexpr( IS_SOA )
+						components.set(numComponentsInPrimary, component);
+					else
+						components.at(numComponentsInPrimary) = component;
 					numComponentsInPrimary++;
+					RV_ECS_STATISTICS(if( statistics ) statistics->moved++);
 				}
 			}
 
@@ -252,28 +515,41 @@ namespace River::ECS {
 
 
 		void deleteComponents() {
+			RV_ECS_STATISTICS_TIMER(statistics ? &statistics->deleteNanoseconds : nullptr);
+
 			// we assume that all components have been moved to the primary list
-			for( auto& componentId : componentsToDelete ) {
-				auto entity = entityMap.find(componentId)->second;
-				unsigned int index = indexMap.find(componentId)->second;
+			for( auto entity : componentsToDelete ) {
+				unsigned int slot = getEntitySlot(entity);
+				unsigned int index = entityIndices[slot];
+				if( index == NO_INDEX )
+					continue; // Marked more than once
 
-				auto& component = components.at(index);
+				ComponentId componentId = getIdAt(index);
 
-				bool isNotLast = (index + 1) < numComponents;
-				if( isNotLast ) {
+				unsigned int last = numComponents - 1;
+				if( index < last ) {
 					// Move last component to the now empty slot
-					auto& last = components.at(numComponents-1);
-					component = last;
-					indexMap.at(last.id) = index;
+					if constexpr( IS_SOA )
+						components.move(last, index);
+					else
+						components.at(index) = components.at(last);
+
+					Entity* lastEntity = componentEntities[last];
+					componentEntities[index] = lastEntity;
+					entityIndices[getEntitySlot(lastEntity)] = index;
+					componentIndices[getIdAt(index)] = index;
+					RV_ECS_STATISTICS(if( statistics ) statistics->swapped++);
 				}
 
 				// Delete component
-				componentMap.erase(entity);
-				entityMap.erase(componentId);
-				indexMap.erase(componentId);
+				componentEntities.pop_back();
+				entityIndices[slot] = NO_INDEX;
+				componentIndices[componentId] = NO_INDEX;
+				freeIds.push_back(componentId);
 
 				numComponentsInPrimary--;
 				numComponents--;
+				RV_ECS_STATISTICS(if( statistics ) statistics->removed++);
 			}
 
 			componentsToDelete.clear();
@@ -282,24 +558,37 @@ namespace River::ECS {
 
 
 	private:
-		ComponentId nextId = 1;
+		inline static const unsigned int NO_INDEX = std::numeric_limits<unsigned int>::max();
 
-		// Maps entity to component id
-		std::unordered_map<Entity*, ComponentId> componentMap;
+		std::pmr::memory_resource* memoryResource;
 
-		// Maps component id to entity
-		std::unordered_map<ComponentId, Entity*> entityMap;
+		/**
+		 * @brief Maps an Entity's slot (see Entity) to the index of its component, or NO_INDEX if it has none */
+		std::pmr::vector<unsigned int> entityIndices;
 
-		// Maps component id to index in component list
-		std::unordered_map<ComponentId, unsigned int> indexMap;
+		/**
+		 * @brief Maps a ComponentId to the index of its component, or NO_INDEX if the id isn't in use */
+		std::pmr::vector<unsigned int> componentIndices;
 
-		std::unordered_set<ComponentId> componentsToDelete;
+		/**
+		 * @brief The Entity of each component (in the order of the components) */
+		std::pmr::vector<Entity*> componentEntities;
 
-		std::vector<std::vector<C>> newComponents;
+		/**
+		 * @brief Ids of deleted components, which are reused before new ids are handed out */
+		std::pmr::vector<ComponentId> freeIds;
+
+		/**
+		 * @brief Entities whose component is deleted on clean (may contain duplicates) */
+		std::pmr::vector<Entity*> componentsToDelete;
+
+		std::pmr::vector<std::pmr::vector<C>> newComponents;
 
 		unsigned int numComponents = 0;
 		unsigned int numComponentsInPrimary = 0; // Number of components in primary list
-		std::vector<C> components;
+		PrimaryList components;
+
+		friend class ComponentRef<C>;
 	};
 
 
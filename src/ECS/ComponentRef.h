@@ -0,0 +1,150 @@
+#pragma once
+
+#include <limits>
+#include <string>
+#include <typeinfo>
+
+#include "ComponentController.h"
+#include "Exception.h"
+
+
+// Checks that ComponentRefs aren't used after they've been invalidated (on by default in debug builds)
+#if defined(_DEBUG) && !defined(RV_ECS_CHECK_COMPONENT_REFS)
+#define RV_ECS_CHECK_COMPONENT_REFS
+#endif
+
+
+namespace River::ECS {
+
+	// Thrown if a ComponentRef is used after its Domain has been cleaned (only if RV_ECS_CHECK_COMPONENT_REFS is defined)
+	class InvalidComponentRefException : public Exception {
+	public:
+		InvalidComponentRefException(const std::string& componentName) : Exception("ComponentRef of '" + componentName + "' was used after its Domain was cleaned") {}
+	};
+
+
+	/**
+	 * @brief	Handle to a Domain's components of type C, which gives direct access to the components by their
+	 *			index. The index of an Entity's component is looked up once with getIndex(), after which reading
+	 *			the component is a single array load.
+	 *
+	 * @details	The handle and the indices are valid until the Domain is cleaned (or restored). Components
+	 *			added since the last clean may not have an index yet. If the type is stored as a structure of
+	 *			arrays (see ComponentFields), components are accessed through ComponentFieldsRefs, and the field
+	 *			arrays can be accessed directly with getField().
+	 * @tparam	C	The type of component
+	*/
+	template <typename C>
+	class ComponentRef {
+		inline static const bool IS_SOA = ComponentFields<C>::IS_SOA;
+
+	public:
+
+		inline static const unsigned int NO_INDEX = std::numeric_limits<unsigned int>::max();
+
+
+		/**
+		 * @return	Index of the Entity's component, or NO_INDEX if the Entity doesn't have the component
+		*/
+		unsigned int getIndex(Entity* entity) const {
+			checkValid();
+			// New components (which aren't in the primary list yet) have indices past the cleaned components
+			unsigned int index = controller->getEntityIndex(entity);
+			return index < controller->numComponentsInPrimary ? index : NO_INDEX;
+		}
+
+
+		/**
+		 * @return	The component at the index (returned by getIndex()): a C&, or a ComponentFieldsRef<C> if the
+		 *			type is stored as a structure of arrays
+		*/
+		decltype(auto) operator[](unsigned int index) const {
+#ifdef RV_ECS_CHECK_COMPONENT_REFS
+			checkValid();
+			if( index >= controller->numComponentsInPrimary )
+				throw std::out_of_range("ComponentRef index " + std::to_string(index) + " is out of range");
+#endif
+			if constexpr( IS_SOA )
+				return ComponentFieldsRef<C>(components, index);
+			else
+				return components[index];
+		}
+
+
+		/**
+		 * @return	Pointer to the Entity's component, or nullptr if the Entity doesn't have the component
+		*/
+		ComponentPointer<C> get(Entity* entity) const {
+			unsigned int index = getIndex(entity);
+			if( index == NO_INDEX )
+				return nullptr;
+			if constexpr( IS_SOA )
+				return ComponentFieldsRef<C>(components, index);
+			else
+				return &components[index];
+		}
+
+
+		/**
+		 * @return	The array of the field (indexed like the components), if the type is stored as a structure of arrays
+		*/
+		template <auto Field>
+		FieldType<Field>* getField() const {
+			static_assert(IS_SOA, "Component type isn't stored as a structure of arrays (see ComponentFields)");
+			checkValid();
+			return components->template getArray<Field>();
+		}
+
+
+		/**
+		 * @return	Number of components with an index (indices are in the range [0, size()))
+		*/
+		unsigned int size() const {
+			return controller->numComponentsInPrimary;
+		}
+
+
+	private:
+		ComponentRef(ComponentController<C>* controller, [[maybe_unused]] const unsigned int* domainEpoch) :
+			controller(controller),
+			components(getPrimaryList(controller))
+		{
+#ifdef RV_ECS_CHECK_COMPONENT_REFS
+			this->domainEpoch = domainEpoch;
+			epoch = *domainEpoch;
+#endif
+		}
+
+		static auto getPrimaryList(ComponentController<C>* controller) {
+			if constexpr( IS_SOA )
+				return &controller->components;
+			else
+				return controller->components.data();
+		}
+
+		void checkValid() const {
+#ifdef RV_ECS_CHECK_COMPONENT_REFS
+			if( epoch != *domainEpoch )
+				throw InvalidComponentRefException(typeid(C).name());
+#endif
+		}
+
+	private:
+		ComponentController<C>* controller;
+
+		/**
+		 * @brief The controller's primary list (which isn't moved until the controller is cleaned) */
+		std::conditional_t<IS_SOA, ComponentFieldArrays<C>*, C*> components;
+
+#ifdef RV_ECS_CHECK_COMPONENT_REFS
+		const unsigned int* domainEpoch;
+
+		/**
+		 * @brief The Domain's epoch when the ref was created */
+		unsigned int epoch;
+#endif
+
+		friend class Domain;
+	};
+
+}
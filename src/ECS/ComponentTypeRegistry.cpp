@@ -1,10 +1,23 @@
-
 #include "ComponentTypeRegistry.h"
 
 namespace River::ECS {
 
-	ComponentTypeId ComponentTypeRegistry::numTypes = 0;
+	std::mutex ComponentTypeRegistry::mutex;
+
+	std::atomic<unsigned int> ComponentTypeRegistry::numTypes = 0;
+
+
+	ComponentTypeId ComponentTypeRegistry::registerType(const std::string& typeName) {
+		// Function-local, so it's constructed before any static Domain may register a type
+		static std::unordered_map<std::string, ComponentTypeId> types;
+
+		std::lock_guard<std::mutex> lock(mutex);
+		auto typeIdIterator = types.find(typeName);
+		if( typeIdIterator != types.end() ) return typeIdIterator->second;
 
-	std::unordered_map<std::string, ComponentTypeId> ComponentTypeRegistry::types;
+		auto typeId = types.emplace(typeName, (ComponentTypeId)numTypes.load(std::memory_order_relaxed)).first->second;
+		numTypes.store(typeId + 1, std::memory_order_release);
+		return typeId;
+	}
 
-}
\ No newline at end of file
+}
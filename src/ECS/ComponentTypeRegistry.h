@@ -2,11 +2,22 @@
 
 #include <unordered_map>
 #include <typeinfo>
+#include <string>
+#include <mutex>
+#include <atomic>
 
 #include "Component.h"
 
 
 namespace River::ECS {
+
+	/**
+	 * @brief	Assigns each component type a process-wide ComponentTypeId
+	 *
+	 * @details	Registering a type takes a lock, and only happens the first time its id is requested (in any thread).
+	 *			After that, getTypeId() only reads the type's static id, so it's safe and cheap to call from
+	 *			any thread. Use registerComponents() at startup to assign the ids before they're needed.
+	*/
 	class ComponentTypeRegistry {
 	public:
 
@@ -21,25 +32,36 @@ namespace River::ECS {
 		template <typename C>
 		static ComponentTypeId getTypeId() {
 			RV_ECS_ASSERT_COMPONENT_TYPE(C);
-			
-			auto typeName = std::string(typeid(C).name());
-			auto typeIdIterator = types.find(typeName);
-			if( typeIdIterator != types.end() ) return typeIdIterator->second;
-
-			auto typeId = types.emplace(typeName, numTypes++).first->second;
 
+			// Initialized once (thread-safe), and only read afterwards
+			static const ComponentTypeId typeId = registerType(typeid(C).name());
 			return typeId;
 		}
 
 
+		/**
+		 * @brief	Registers the component types (in the given order), so their ids are assigned up front
+		*/
+		template <typename ... C>
+		static void registerComponents() {
+			(getTypeId<C>(), ...);
+		}
+
+
 		static unsigned int getNumTypes() {
-			return (unsigned int) types.size();
+			return numTypes.load(std::memory_order_acquire);
 		}
 
 
 	private:
-		static ComponentTypeId numTypes;
-		static std::unordered_map<std::string, ComponentTypeId> types;
+
+		/**
+		 * @return	The id of the type with the given name, which is assigned if the type hasn't been registered
+		*/
+		static ComponentTypeId registerType(const std::string& typeName);
+
+		static std::mutex mutex;
+		static std::atomic<unsigned int> numTypes;
 
 	};
 
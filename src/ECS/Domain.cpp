@@ -1,16 +1,40 @@
 #include "Domain.h"
 
 #include "Entity.h"
+#include "DomainSnapshot.h"
+#include "ChangeTracker.h"
 
 #include "ECS/Log.h"
 
+#include <algorithm>
+
 namespace River::ECS {
 
 	/**
 	 * @brief 
 	*/
-	Domain::Domain() : signatures(5000) {
-	
+	Domain::Domain(const DomainSettings& settings) :
+		settings(settings),
+		arena(settings.useArena ? new std::pmr::unsynchronized_pool_resource(settings.memoryResource) : nullptr),
+		memoryResource(settings.useArena ? arena.get() : settings.memoryResource),
+		frameArena(settings.frameArenaSize, memoryResource),
+		newEntities(&frameArena),
+		entitiesToDelete(&frameArena),
+		entityComponentsToCreate(&frameArena),
+		entityComponentsToDelete(&frameArena),
+		entities(memoryResource),
+		signatures(5000, memoryResource, settings.signatureLayout),
+		typeSignatureBits(memoryResource),
+		signatureBitControllers(memoryResource),
+		dirtyControllers(&frameArena),
+		dirtyControllerFlags(&frameArena),
+		componentDeletions(&frameArena),
+		componentControllers(memoryResource),
+		retiredEntities(memoryResource),
+		freeEntitySlots(memoryResource),
+		changeTrackers(memoryResource)
+	{
+		signatures.reserveSignatureSize(settings.reservedComponentTypes);
 	}
 
 
@@ -18,21 +42,29 @@ namespace River::ECS {
 		for( auto componentController : componentControllers )
 			delete componentController.second;
 		for( auto entity : entities )
-			delete entity;	
+			deallocateEntity(entity);
+		for( auto entity : newEntities )
+			deallocateEntity(entity);
+		for( auto entity : retiredEntities )
+			deallocateEntity(entity);
 	}
 
 
 	Entity* Domain::createEntity() {
 		/* This has to be implemented in the .cpp file, due to cyclic includes */
-		auto entity = new Entity(*this);
-		newEntities.emplace(entity);	
+		auto entity = allocateEntity(nextEntityId++);
+		newEntities.push_back(entity);
+		RV_ECS_STATISTICS(frameStatistics.entitiesCreated++);
 		return entity;
 	}
 
 	void Domain::clean() {
+		RV_ECS_STATISTICS(StatisticsTimer timer);
+		RV_ECS_TRACE_SCOPE("Domain::clean");
+		RV_ECS_TRACE(TraceScope phase("Domain::clean: create entities"));
 
 		// Adjust size of signaturearray
-		signatures.setSignatureSize(ComponentTypeRegistry::getNumTypes());
+		signatures.setSignatureSize(numSignatureBits);
 		
 		// Move new entities
 		signatures.reserveSignatures(signatures.getNumSignatures() + (unsigned int) newEntities.size());
@@ -40,82 +72,96 @@ namespace River::ECS {
 		for( auto& newEntity : newEntities ) {
 			entities.push_back(newEntity);
 			// Adding signature (not registering components)
-			auto signatureIndex = signatures.add();
-			entitySignatureIndexMap.emplace(newEntity, signatureIndex);
-			{
-				auto insertResult = signatureIndexEntityMap.emplace(signatureIndex, newEntity);
-				if( !insertResult.second )
-					throw new Exception("Storing signature index failed");
-			}
+			newEntity->signatureIndex = signatures.add(newEntity);
 		}
+		RV_ECS_STATISTICS(timer.lap(frameStatistics.createEntitiesNanoseconds));
+		RV_ECS_TRACE(phase.next("Domain::clean: add components"));
 
 		// Moving new components into signatures
 		for( auto& pair : entityComponentsToCreate ) {
-			auto entity = pair.first;
-			auto signatureIndex = entitySignatureIndexMap.find(entity)->second;
-			for( auto& component : pair.second ) {
-				signatures.setSignatureBit(signatureIndex, component);
-			}
+			signatures.setSignatureBit(pair.first->signatureIndex, getSignatureBit(pair.second));
 		}
+		RV_ECS_STATISTICS(timer.lap(frameStatistics.addComponentsNanoseconds));
+		RV_ECS_TRACE(phase.next("Domain::clean: remove components"));
 
 		// Delete entity components
 		for( auto& pair : entityComponentsToDelete ) {
-			auto entity = pair.first;
-			auto signatureIndex = entitySignatureIndexMap.find(entity)->second;
-			for( auto& component : pair.second ) {
-				signatures.unsetSignatureBit(signatureIndex, component);
-				componentControllers.find(component)->second->deleteComponent(entity);
-			}
+			auto signatureBit = getSignatureBit(pair.second);
+			signatures.unsetSignatureBit(pair.first->signatureIndex, signatureBit);
+			addComponentDeletion(signatureBit, pair.first);
 		}
+		RV_ECS_STATISTICS(timer.lap(frameStatistics.removeComponentsNanoseconds));
+		RV_ECS_TRACE(phase.next("Domain::clean: destroy entities"));
+
+		// Remove duplicates (sorting by id, so entities are deleted in a deterministic order)
+		std::sort(entitiesToDelete.begin(), entitiesToDelete.end(), [](Entity* a, Entity* b) {
+			return a->getId() < b->getId();
+		});
+		entitiesToDelete.erase(std::unique(entitiesToDelete.begin(), entitiesToDelete.end()), entitiesToDelete.end());
+
+		if( !changeTrackers.empty() )
+			trackChanges();
 
 		// Delete entities
 		for( auto& entity : entitiesToDelete ) {
-			auto signatureIndex = entitySignatureIndexMap.find(entity)->second;
-			
-			auto movedSignature = signatures.remove(signatureIndex);
-			if( movedSignature != 0 ) {
-				// Change signature index of moved signature (signature which was moved into the deleted signature's place)
-				auto movedEntity = signatureIndexEntityMap.find(movedSignature)->second;
-				signatureIndexEntityMap.erase(movedSignature);
-				signatureIndexEntityMap.find(signatureIndex)->second = movedEntity;
-				entitySignatureIndexMap.find(movedEntity)->second = signatureIndex;
-			} else {
-				signatureIndexEntityMap.erase(signatureIndex);
-			}
-
-			entitySignatureIndexMap.erase(entity);
-
-			// TODO: Use signatures.forEachBit thingy to iterate over ComponentControllers
-			for( auto& componentController : componentControllers ) {
-				componentController.second->deleteComponent(entity);
-			}
+			auto signatureIndex = entity->signatureIndex;
 
+			// Only the controllers of the entity's components have to delete a component
+			signatures.forEachSetBit(signatureIndex, [this, entity](unsigned int signatureBit) {
+				addComponentDeletion(signatureBit, entity);
+			});
 			
-			// Remove entity from entities list
-			auto entityIterator = std::find(entities.begin(), entities.end(), entity);
-			if( entityIterator != entities.end() )
-				entities.erase(entityIterator);
+			// The last signature (and its entity) is moved into the deleted signature's place
+			signatures.remove(signatureIndex);
+			if( signatureIndex < signatures.getNumSignatures() )
+				signatures.getEntity(signatureIndex)->signatureIndex = signatureIndex;
+
+			entity->signatureIndex = Entity::NO_SIGNATURE_INDEX;
+		}
 
-			delete entity;
+		// Remove the deleted entities from the entities list (in one pass, keeping the order of the rest)
+		if( !entitiesToDelete.empty() ) {
+			entities.erase(std::remove_if(entities.begin(), entities.end(), [](Entity* entity) {
+				return entity->signatureIndex == Entity::NO_SIGNATURE_INDEX;
+			}), entities.end());
 		}
 
-		// Clean component controllers (delete components marked for deletion)
-		for( auto& componentController : componentControllers ) {
-			componentController.second->clean();
+		RV_ECS_STATISTICS(frameStatistics.entitiesDestroyed += (unsigned int)entitiesToDelete.size());
+		RV_ECS_STATISTICS(timer.lap(frameStatistics.destroyEntitiesNanoseconds));
+		RV_ECS_TRACE(phase.next("Domain::clean: clean controllers"));
+
+		// Clean the component controllers which have changes (deleting components in one call per controller)
+		for( auto signatureBit : dirtyControllers ) {
+			auto componentController = signatureBitControllers[signatureBit];
+			if( signatureBit < componentDeletions.size() && !componentDeletions[signatureBit].empty() )
+				componentController->deleteEntityComponents(componentDeletions[signatureBit].data(), componentDeletions[signatureBit].size());
+			componentController->clean();
 		}
 
+		// The destroyed entities are retired after the controllers have deleted their components, as the
+		// controllers look the components up by the entities' slots
+		for( auto& entity : entitiesToDelete )
+			retireEntity(entity);
+		RV_ECS_STATISTICS(timer.lap(frameStatistics.cleanControllersNanoseconds));
+
 
-		entityComponentsToCreate.clear();
-		entityComponentsToDelete.clear();
-		entitiesToDelete.clear();
-		newEntities.clear();
+		clearChanges();
+		cleanEpoch++;
+
+		RV_ECS_STATISTICS(frameStatistics.cleanNanoseconds += timer.getElapsed());
+		RV_ECS_STATISTICS(endStatisticsFrame());
 	}
 
 
 	void Domain::destroyEntity(Entity* entity) {
 		/* This has to be implemented in the .cpp file, due to cyclic includes */
-		if( entitiesToDelete.find(entity) == entitiesToDelete.end() )
-			entitiesToDelete.insert(entity);
+		entitiesToDelete.push_back(entity);
+	}
+
+
+	void Domain::markEntityChanged(Entity* entity) {
+		for( auto tracker : changeTrackers )
+			tracker->addChanged(entity);
 	}
 
 
@@ -124,6 +170,286 @@ namespace River::ECS {
 	}
 
 
+	void Domain::forEachEntity(std::function<void(Entity*)> callback) {
+		for( auto entity : entities )
+			callback(entity);
+	}
+
+
+	void Domain::snapshot(DomainSnapshot& snapshot) {
+		if( &snapshot.domain != this )
+			throw Exception("Snapshot was created for another Domain");
+		checkClean("storing a snapshot");
+
+		// The entities of the previously stored state are released after the current ones are referenced, so
+		// entities in both aren't deleted
+		referenceEntities(entities);
+		if( snapshot.stored )
+			releaseEntities(snapshot.entities);
+
+		snapshot.nextEntityId = nextEntityId;
+		snapshot.entities = entities;
+		snapshot.signatures.copyFrom(signatures);
+
+		// Controllers from a previous snapshot are reused
+		for( auto& pair : componentControllers ) {
+			auto snapshotController = snapshot.componentControllers.find(pair.first);
+			if( snapshotController == snapshot.componentControllers.end() )
+				snapshot.componentControllers.emplace(pair.first, pair.second->clone());
+			else
+				snapshotController->second->restore(*pair.second);
+		}
+
+		snapshot.stored = true;
+	}
+
+
+	void Domain::restore(const DomainSnapshot& snapshot) {
+		if( &snapshot.domain != this )
+			throw Exception("Snapshot was created for another Domain");
+		if( !snapshot.stored )
+			throw Exception("Snapshot has not been stored");
+
+		// Entities which don't exist in the snapshot are destroyed, and entities which have been
+		// destroyed since the snapshot are brought back (with the signature indices of the snapshot)
+		for( auto entity : entities )
+			entity->signatureIndex = Entity::NO_SIGNATURE_INDEX;
+		for( unsigned int signatureIndex = 0; signatureIndex < snapshot.signatures.getNumSignatures(); signatureIndex++ )
+			snapshot.signatures.getEntity(signatureIndex)->signatureIndex = signatureIndex;
+
+		for( auto entity : entities ) {
+			if( entity->signatureIndex == Entity::NO_SIGNATURE_INDEX )
+				retireEntity(entity);
+		}
+		for( auto entity : newEntities )
+			retireEntity(entity);
+		for( auto entity : snapshot.entities )
+			retiredEntities.erase(entity);
+
+		nextEntityId = snapshot.nextEntityId;
+		entities = snapshot.entities;
+		signatures.copyFrom(snapshot.signatures);
+
+		for( auto& pair : componentControllers ) {
+			auto snapshotController = snapshot.componentControllers.find(pair.first);
+			if( snapshotController == snapshot.componentControllers.end() )
+				pair.second->clear(); // Component type was first used after the snapshot
+			else
+				pair.second->restore(*snapshotController->second);
+		}
+
+		for( auto tracker : changeTrackers )
+			tracker->setAllChanged();
+
+		clearChanges();
+		cleanEpoch++;
+	}
+
+
+	Domain* Domain::clone() {
+		checkClean("cloning");
+
+		auto domain = new Domain(settings);
+		domain->nextEntityId = nextEntityId;
+
+		// The cloned entities get the slots of the original entities, so the controllers' slot arrays stay valid,
+		// and the original entities are mapped to the clones through their slots
+		std::vector<Entity*> clonedEntitiesBySlot(numEntitySlots, nullptr);
+		domain->numEntitySlots = numEntitySlots;
+		domain->entities.reserve(entities.size());
+		for( auto entity : entities ) {
+			auto clonedEntity = domain->allocateEntity(entity->getId(), entity->slot);
+			clonedEntitiesBySlot[entity->slot] = clonedEntity;
+			domain->entities.push_back(clonedEntity);
+		}
+
+		// Slots of the new and retired entities aren't used by the clone (the lowest free slots are reused first)
+		for( unsigned int slot = numEntitySlots; slot-- > 0; ) {
+			if( clonedEntitiesBySlot[slot] == nullptr )
+				domain->freeEntitySlots.push_back(slot);
+		}
+
+		domain->signatures.copyFrom(signatures);
+		for( unsigned int signatureIndex = 0; signatureIndex < signatures.getNumSignatures(); signatureIndex++ ) {
+			auto clonedEntity = clonedEntitiesBySlot[signatures.getEntity(signatureIndex)->slot];
+			clonedEntity->signatureIndex = signatureIndex;
+			domain->signatures.setEntity(signatureIndex, clonedEntity);
+		}
+		domain->typeSignatureBits = typeSignatureBits;
+		domain->numSignatureBits = numSignatureBits;
+		domain->signatureBitControllers.resize(numSignatureBits);
+
+		for( auto& pair : componentControllers ) {
+			auto clonedController = pair.second->clone();
+			clonedController->remapEntities(clonedEntitiesBySlot);
+			domain->componentControllers.emplace(pair.first, clonedController);
+			domain->signatureBitControllers[getSignatureBit(pair.first)] = clonedController;
+			RV_ECS_STATISTICS(domain->recordComponentType(pair.first, clonedController, frameStatistics.componentTypes[pair.first].name));
+		}
+
+		return domain;
+	}
+
+
+	MemoryReport Domain::memoryReport() const {
+		MemoryReport report;
+
+		size_t numEntityObjects = entities.size() + newEntities.size() + retiredEntities.size();
+		report.structures["entityObjects"] = { numEntityObjects * sizeof(Entity), numEntityObjects * sizeof(Entity) };
+		report.structures["entities"] = getVectorMemoryUsage(entities);
+		report.structures["signatureEntities"] = signatures.getEntityMemoryUsage();
+		report.structures["retiredEntities"] = getHashTableMemoryUsage(retiredEntities);
+		report.structures["freeEntitySlots"] = getVectorMemoryUsage(freeEntitySlots);
+		report.structures["componentControllers"] = getHashTableMemoryUsage(componentControllers);
+		report.structures["signatureRows"] = signatures.getRowMemoryUsage();
+		report.structures["signatureColumns"] = signatures.getColumnMemoryUsage();
+		report.structures["typeSignatureBits"] = getVectorMemoryUsage(typeSignatureBits);
+		report.structures["signatureBitControllers"] = getVectorMemoryUsage(signatureBitControllers);
+
+		// The lists of changes to clean are allocated in the frame arena
+		report.structures["frameArena"] = { frameArena.getBytesAllocated(), frameArena.getCapacity() };
+
+		for( auto& pair : componentControllers )
+			report.componentTypes.emplace(pair.first, pair.second->getMemoryReport());
+
+		return report;
+	}
+
+
+	void Domain::addSignatureBit(ComponentTypeId typeId, IComponentController* controller) {
+		if( typeSignatureBits.size() <= typeId )
+			typeSignatureBits.resize(typeId + 1, NO_SIGNATURE_BIT);
+		typeSignatureBits[typeId] = numSignatureBits++;
+		signatureBitControllers.push_back(controller);
+	}
+
+
+	void Domain::markControllerDirty(unsigned int signatureBit) {
+		if( dirtyControllerFlags.size() <= signatureBit )
+			dirtyControllerFlags.resize(numSignatureBits, false);
+		if( dirtyControllerFlags[signatureBit] ) return;
+		dirtyControllerFlags[signatureBit] = true;
+		dirtyControllers.push_back(signatureBit);
+	}
+
+
+	void Domain::addComponentDeletion(unsigned int signatureBit, Entity* entity) {
+		if( componentDeletions.size() <= signatureBit )
+			componentDeletions.resize(numSignatureBits);
+		componentDeletions[signatureBit].push_back(entity);
+		markControllerDirty(signatureBit);
+	}
+
+
+	void Domain::recordComponentType(ComponentTypeId typeId, IComponentController* controller, const std::string& name) {
+		auto& componentTypeStatistics = frameStatistics.componentTypes[typeId];
+		componentTypeStatistics.name = name;
+		controller->setStatistics(&componentTypeStatistics);
+	}
+
+
+	void Domain::endStatisticsFrame() {
+		for( auto componentController : signatureBitControllers )
+			componentController->recordLayoutStatistics();
+
+		statistics = frameStatistics;
+		frameStatistics.reset();
+	}
+
+
+	void Domain::clearChanges() {
+		// The lists' memory is owned by the frame arena, so they are replaced before the arena is reset
+		newEntities = std::pmr::vector<Entity*>(&frameArena);
+		entitiesToDelete = std::pmr::vector<Entity*>(&frameArena);
+		entityComponentsToCreate = std::pmr::vector<std::pair<Entity*, ComponentTypeId>>(&frameArena);
+		entityComponentsToDelete = std::pmr::vector<std::pair<Entity*, ComponentTypeId>>(&frameArena);
+		dirtyControllers = std::pmr::vector<unsigned int>(&frameArena);
+		dirtyControllerFlags = std::pmr::vector<bool>(&frameArena);
+		componentDeletions = std::pmr::vector<std::pmr::vector<Entity*>>(&frameArena);
+		frameArena.reset();
+	}
+
+
+	void Domain::trackChanges() {
+		for( auto tracker : changeTrackers ) {
+			for( auto entity : newEntities )
+				tracker->addChanged(entity);
+			for( auto& pair : entityComponentsToCreate )
+				tracker->addChanged(pair.first);
+			for( auto& pair : entityComponentsToDelete )
+				tracker->addChanged(pair.first);
+			// After the other changes, so destroyed entities are removed from the changed entities
+			for( auto entity : entitiesToDelete )
+				tracker->addDestroyed(entity);
+		}
+	}
+
+
+	void Domain::checkClean(const std::string& operation) {
+		bool isClean =
+			newEntities.empty() &&
+			entitiesToDelete.empty() &&
+			entityComponentsToCreate.empty() &&
+			entityComponentsToDelete.empty();
+		if( !isClean )
+			throw DomainNotCleanException(operation);
+	}
+
+
+	Entity* Domain::allocateEntity(EntityId id) {
+		unsigned int slot;
+		if( freeEntitySlots.empty() ) {
+			slot = numEntitySlots++;
+		} else {
+			slot = freeEntitySlots.back();
+			freeEntitySlots.pop_back();
+		}
+		return allocateEntity(id, slot);
+	}
+
+
+	Entity* Domain::allocateEntity(EntityId id, unsigned int slot) {
+		void* memory = memoryResource->allocate(sizeof(Entity), alignof(Entity));
+		return new (memory) Entity(*this, id, slot);
+	}
+
+
+	void Domain::deallocateEntity(Entity* entity) {
+		freeEntitySlots.push_back(entity->slot);
+		entity->~Entity();
+		memoryResource->deallocate(entity, sizeof(Entity), alignof(Entity));
+	}
+
+
+	void Domain::retireEntity(Entity* entity) {
+		if( entity->snapshotReferences > 0 )
+			retiredEntities.insert(entity);
+		else
+			deallocateEntity(entity);
+	}
+
+
+	void Domain::referenceEntities(const std::pmr::vector<Entity*>& entities) {
+		for( auto entity : entities )
+			entity->snapshotReferences++;
+	}
+
+
+	void Domain::releaseEntities(const std::pmr::vector<Entity*>& entities) {
+		for( auto entity : entities ) {
+			// Entities which are still in the Domain aren't retired
+			if( --entity->snapshotReferences == 0 && retiredEntities.erase(entity) > 0 )
+				deallocateEntity(entity);
+		}
+	}
+
+
+	void Domain::releaseSnapshot(DomainSnapshot& snapshot) {
+		if( snapshot.stored )
+			releaseEntities(snapshot.entities);
+	}
+
+
 
 
 	
@@ -0,0 +1,20 @@
+#include "DomainSnapshot.h"
+
+
+namespace River::ECS {
+
+	DomainSnapshot::DomainSnapshot(Domain& domain) :
+		domain(domain),
+		entities(domain.memoryResource),
+		signatures(0, domain.memoryResource),
+		componentControllers(domain.memoryResource)
+	{}
+
+
+	DomainSnapshot::~DomainSnapshot() {
+		for( auto componentController : componentControllers )
+			delete componentController.second;
+		domain.releaseSnapshot(*this);
+	}
+
+}
@@ -0,0 +1,63 @@
+#pragma once
+
+#include <vector>
+#include <unordered_map>
+
+#include "Domain.h"
+
+
+namespace River::ECS {
+
+	/**
+	 * @brief	Stores a copy of a Domain's entities and components, so the Domain can be rolled back to it.
+	 *			The snapshot is filled by Domain::snapshot(), and restored by Domain::restore().
+	 *
+	 * @details	The snapshot must be destroyed before its Domain.
+	*/
+	class DomainSnapshot {
+	public:
+
+		/**
+		 * @param domain	The Domain which this snapshot may store the state of
+		*/
+		DomainSnapshot(Domain& domain);
+		~DomainSnapshot();
+
+
+		Domain& getDomain() const {
+			return domain;
+		}
+
+
+		/**
+		 * @return	Whether or not the Domain's state has been stored in this snapshot
+		*/
+		bool isStored() const {
+			return stored;
+		}
+
+
+	private:
+		DomainSnapshot(const DomainSnapshot&) = delete;
+		DomainSnapshot& operator=(const DomainSnapshot&) = delete;
+
+
+	private:
+		Domain& domain;
+
+		bool stored = false;
+
+		EntityId nextEntityId = NULL_ENTITY_ID;
+
+		std::pmr::vector<Entity*> entities;
+
+		/**
+		 * @brief The signatures, and the Entity of each signature */
+		SignatureArray signatures;
+
+		std::pmr::unordered_map<ComponentTypeId, IComponentController*> componentControllers;
+
+		friend class Domain;
+	};
+
+}
@@ -7,6 +7,7 @@ namespace River::ECS {
 	struct Entity {
 
 		friend class Domain;
+		friend unsigned int getEntitySlot(const Entity* entity);
 
 	public:
 
@@ -15,6 +16,15 @@ namespace River::ECS {
 		}
 
 
+		/**
+		 * @return	The Entity's ID, which is unique within its Domain. IDs are never reused, unless the Domain
+					is restored to a snapshot taken before the ID was handed out.
+		*/
+		EntityId getId() const {
+			return id;
+		}
+
+
 		// TODO: Document
 		template <typename C>
 		C* addComponent() {
@@ -25,7 +35,7 @@ namespace River::ECS {
 
 		// TODO: Document
 		template <typename C>
-		C* getComponent() {
+		ComponentPointer<C> getComponent() {
 			RV_ECS_ASSERT_COMPONENT_TYPE(C);
 			return domain.getEntityComponent<C>(this);
 		}
@@ -38,6 +48,15 @@ namespace River::ECS {
 			domain.removeEntityComponent<C>(this);
 		}
 
+
+		/**
+		 * @brief	Marks that the Entity's component data has been written, so the Domain's ChangeTrackers (and with
+		 *			them DeltaEncoders) pick up the change. Adding and removing components doesn't have to be marked.
+		*/
+		void markChanged() {
+			domain.markEntityChanged(this);
+		}
+
 		
 		void destroy() {
 			domain.destroyEntity(this);
@@ -46,7 +65,7 @@ namespace River::ECS {
 
 	private:
 		
-		Entity(Domain& domain) : domain(domain) { }
+		Entity(Domain& domain, EntityId id, unsigned int slot) : domain(domain), id(id), slot(slot) { }
 
 		// Prevents entity from being deleted by anyone else than Domain
 		~Entity() { }
@@ -58,6 +77,28 @@ namespace River::ECS {
 
 		Domain& domain;
 
+		EntityId id;
+
+		/**
+		 * @brief Dense number which is unique among the Domain's allocated Entity objects (including new and retired
+		 *			entities), and reused after the Entity is deleted. Component controllers index their arrays with it. */
+		unsigned int slot;
+
+		inline static const unsigned int NO_SIGNATURE_INDEX = std::numeric_limits<unsigned int>::max();
+
+		/**
+		 * @brief Index of the Entity's signature in its Domain's signature array (NO_SIGNATURE_INDEX until it's cleaned) */
+		unsigned int signatureIndex = NO_SIGNATURE_INDEX;
+
+		/**
+		 * @brief Number of stored DomainSnapshots which contain the Entity (it isn't deleted while this is above 0) */
+		unsigned int snapshotReferences = 0;
+
 	};
 
+
+	inline unsigned int getEntitySlot(const Entity* entity) {
+		return entity->slot;
+	}
+
 }
\ No newline at end of file
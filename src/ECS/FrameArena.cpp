@@ -0,0 +1,88 @@
+#include "FrameArena.h"
+
+#include <cstdint>
+
+
+namespace River::ECS {
+
+	FrameArena::FrameArena(size_t initialSize, std::pmr::memory_resource* upstream) : upstream(upstream) {
+		if( initialSize > 0 ) {
+			block = (unsigned char*)upstream->allocate(initialSize, alignof(std::max_align_t));
+			capacity = initialSize;
+		}
+	}
+
+
+	FrameArena::~FrameArena() {
+		reset();
+		if( block != nullptr )
+			upstream->deallocate(block, capacity, alignof(std::max_align_t));
+	}
+
+
+	void FrameArena::reset() {
+		bool overflowed = lastOverflow != nullptr;
+
+		while( lastOverflow != nullptr ) {
+			Overflow* overflow = lastOverflow;
+			lastOverflow = overflow->previous;
+			upstream->deallocate(overflow->memory, overflow->size, overflow->alignment);
+		}
+
+		if( overflowed ) {
+			// Grow the block to fit the entire frame (with some headroom for alignment)
+			size_t newCapacity = capacity == 0 ? 1024 : capacity;
+			while( newCapacity < bytesAllocated + bytesAllocated / 4 )
+				newCapacity *= 2;
+
+			if( block != nullptr )
+				upstream->deallocate(block, capacity, alignof(std::max_align_t));
+			block = (unsigned char*)upstream->allocate(newCapacity, alignof(std::max_align_t));
+			capacity = newCapacity;
+		}
+
+		offset = 0;
+		bytesAllocated = 0;
+	}
+
+
+	void* FrameArena::do_allocate(size_t bytes, size_t alignment) {
+		bytesAllocated += bytes;
+
+		// The block is only aligned to max_align_t, so the address (not the offset) is aligned
+		if( block != nullptr ) {
+			uintptr_t address = reinterpret_cast<uintptr_t>(block) + offset;
+			size_t alignedOffset = offset + (((address + alignment - 1) & ~(uintptr_t)(alignment - 1)) - address);
+			if( alignedOffset + bytes <= capacity ) {
+				offset = alignedOffset + bytes;
+				return block + alignedOffset;
+			}
+		}
+
+		// Block is full, so the allocation is taken from upstream (the header is padded to keep the alignment)
+		size_t headerSize = (sizeof(Overflow) + alignment - 1) & ~(alignment - 1);
+		size_t overflowAlignment = alignment > alignof(Overflow) ? alignment : alignof(Overflow);
+		size_t size = headerSize + bytes;
+
+		auto memory = (unsigned char*)upstream->allocate(size, overflowAlignment);
+		auto overflow = (Overflow*)(memory + headerSize - sizeof(Overflow));
+		overflow->previous = lastOverflow;
+		overflow->memory = memory;
+		overflow->size = size;
+		overflow->alignment = overflowAlignment;
+		lastOverflow = overflow;
+
+		return memory + headerSize;
+	}
+
+
+	void FrameArena::do_deallocate(void* /*p*/, size_t /*bytes*/, size_t /*alignment*/) {
+		// Memory is freed by reset()
+	}
+
+
+	bool FrameArena::do_is_equal(const std::pmr::memory_resource& other) const noexcept {
+		return this == &other;
+	}
+
+}
@@ -0,0 +1,74 @@
+#include "MemoryReport.h"
+
+#include <sstream>
+
+#include "Json.h"
+
+
+namespace River::ECS {
+
+	static MemoryUsage getStructuresTotal(const MemoryStructures& structures) {
+		MemoryUsage total;
+		for( auto& pair : structures )
+			total += pair.second;
+		return total;
+	}
+
+
+	static void writeMemoryUsage(std::ostream& stream, const MemoryUsage& usage) {
+		stream << "{\"usedBytes\":" << usage.usedBytes << ",\"reservedBytes\":" << usage.reservedBytes << "}";
+	}
+
+
+	static void writeStructures(std::ostream& stream, const MemoryStructures& structures) {
+		stream << "{";
+		bool first = true;
+		for( auto& pair : structures ) {
+			if( !first ) stream << ",";
+			first = false;
+			writeJsonString(stream, pair.first);
+			stream << ":";
+			writeMemoryUsage(stream, pair.second);
+		}
+		stream << "}";
+	}
+
+
+	MemoryUsage ComponentTypeMemoryReport::getTotal() const {
+		return getStructuresTotal(structures);
+	}
+
+
+	MemoryUsage MemoryReport::getTotal() const {
+		auto total = getStructuresTotal(structures);
+		for( auto& pair : componentTypes )
+			total += pair.second.getTotal();
+		return total;
+	}
+
+
+	std::string MemoryReport::toJson() const {
+		std::ostringstream stream;
+		stream << "{\"total\":";
+		writeMemoryUsage(stream, getTotal());
+		stream << ",\"structures\":";
+		writeStructures(stream, structures);
+
+		stream << ",\"componentTypes\":[";
+		bool first = true;
+		for( auto& pair : componentTypes ) {
+			if( !first ) stream << ",";
+			first = false;
+			stream << "{\"id\":" << pair.first << ",\"name\":";
+			writeJsonString(stream, pair.second.name);
+			stream << ",\"total\":";
+			writeMemoryUsage(stream, pair.second.getTotal());
+			stream << ",\"structures\":";
+			writeStructures(stream, pair.second.structures);
+			stream << "}";
+		}
+		stream << "]}";
+		return stream.str();
+	}
+
+}
@@ -0,0 +1,209 @@
+#include "DeltaDecoder.h"
+
+#include <cstring>
+#include <unordered_set>
+
+#include "ByteStream.h"
+
+
+namespace River::ECS {
+
+	/**
+	 * @brief	Reads runs written by the encoder's writeXorRuns(), and XOR's them onto the data
+	*/
+	static void applyXorRuns(ByteReader& reader, unsigned char* data, unsigned int size) {
+		unsigned int i = 0;
+		while( i < size ) {
+			uint64_t numZeros = reader.readVarUInt();
+			uint64_t numLiterals = reader.readVarUInt();
+			if( numZeros + numLiterals == 0 || numZeros + numLiterals > size - i )
+				throw DeltaFormatException("invalid component data run");
+
+			i += (unsigned int)numZeros;
+			const unsigned char* literals = reader.readBytes((size_t)numLiterals);
+			for( unsigned int j = 0; j < numLiterals; j++ )
+				data[i + j] ^= literals[j];
+			i += (unsigned int)numLiterals;
+		}
+	}
+
+
+	unsigned int DeltaDecoder::decode(Domain& domain, const unsigned char* data, size_t size) {
+		ByteReader reader(data, size);
+
+		unsigned int deltaTick = (unsigned int)reader.readVarUInt();
+		uint64_t encodedBaselineTick = reader.readVarUInt();
+
+		// Deltas arriving after a newer delta has been applied are ignored
+		if( tick != Snapshot::NO_TICK && deltaTick < tick )
+			return tick;
+
+		// Applying changes on top of uncleaned ones could fail halfway through the delta
+		domain.checkClean("decoding a delta");
+
+		if( history == nullptr )
+			history.reset(new SnapshotHistory(types.getDataSizes()));
+
+		unsigned int baselineTick = Snapshot::NO_TICK;
+		if( encodedBaselineTick != 0 ) {
+			baselineTick = (unsigned int)(encodedBaselineTick - 1);
+			if( baselineTick > deltaTick || !history->hasTick(baselineTick) )
+				throw MissingBaselineException(baselineTick);
+		}
+		bool hasBaseline = baselineTick != Snapshot::NO_TICK;
+
+		// Finds the state of an entity at the baseline (entities don't exist in an empty baseline)
+		const Snapshot& current = history->getCurrent();
+		auto getBaseline = [this, hasBaseline, baselineTick, &current](EntityId id, const Snapshot*& snapshot, int& index) {
+			if( hasBaseline ) {
+				history->getEntityAt(baselineTick, id, snapshot, index);
+			} else {
+				snapshot = &current;
+				index = -1;
+			}
+		};
+
+		// The whole delta is read into the target states before anything is applied, so an invalid delta
+		// leaves the Domain unchanged
+		Snapshot targets(deltaTick, types.getDataSizes());
+		std::vector<EntityId> destroyed;
+		const Snapshot* baseline;
+		int baselineIndex;
+
+		uint64_t numDestroyed = reader.readVarUInt();
+		for( uint64_t i = 0; i < numDestroyed; i++ )
+			destroyed.push_back((EntityId)reader.readVarUInt());
+
+		uint64_t numCreated = reader.readVarUInt();
+		for( uint64_t i = 0; i < numCreated; i++ ) {
+			EntityId id = (EntityId)reader.readVarUInt();
+			getBaseline(id, baseline, baselineIndex);
+			if( baselineIndex >= 0 || targets.findEntity(id) >= 0 )
+				throw DeltaFormatException("entity " + std::to_string(id) + " is created twice");
+			targets.addEntity(id);
+		}
+
+		uint64_t numRecords = reader.readVarUInt();
+		for( uint64_t i = 0; i < numRecords; i++ ) {
+			EntityId id = (EntityId)reader.readVarUInt();
+			int entityIndex = targets.findEntity(id);
+			if( entityIndex < 0 ) {
+				getBaseline(id, baseline, baselineIndex);
+				if( baselineIndex < 0 )
+					throw DeltaFormatException("record for unknown entity " + std::to_string(id));
+				entityIndex = targets.addEntity(id);
+				targets.copyEntity(entityIndex, *baseline, baselineIndex);
+			}
+
+			uint64_t mask = reader.readVarUInt();
+			uint64_t dataMask = reader.readVarUInt();
+			if( (dataMask & ~mask) != 0 || (types.getNumTypes() < Snapshot::MAX_TYPES && (mask >> types.getNumTypes()) != 0) )
+				throw DeltaFormatException("record for entity " + std::to_string(id) + " has unknown component types");
+
+			targets.setMask(entityIndex, mask);
+			for( unsigned int typeIndex = 0; typeIndex < types.getNumTypes(); typeIndex++ ) {
+				if( dataMask & ((uint64_t)1 << typeIndex) )
+					applyXorRuns(reader, targets.getData(entityIndex, typeIndex), targets.getDataSize(typeIndex));
+			}
+		}
+
+		if( !reader.isAtEnd() )
+			throw DeltaFormatException("unexpected data after last record");
+
+		// Entities which aren't in the delta have their baseline state. This only has to be restored for the
+		// entities which have changed since the baseline (or all entities, if there is no baseline).
+		std::unordered_set<EntityId> destroyedIds(destroyed.begin(), destroyed.end());
+		auto revert = [&](EntityId id) {
+			if( targets.findEntity(id) >= 0 || destroyedIds.count(id) > 0 ) return;
+			getBaseline(id, baseline, baselineIndex);
+			if( baselineIndex < 0 ) {
+				destroyed.push_back(id);
+			} else {
+				unsigned int entityIndex = targets.addEntity(id);
+				targets.copyEntity(entityIndex, *baseline, baselineIndex);
+			}
+		};
+		if( hasBaseline ) {
+			history->forEachChangedSince(baselineTick, revert);
+		} else {
+			for( unsigned int i = 0; i < current.getNumEntities(); i++ )
+				revert(current.getEntityId(i));
+		}
+
+		// Apply the changes to the Domain and the current state
+		history->beginTick(deltaTick);
+		for( auto id : destroyed )
+			applyEntity(domain, id, targets, -1);
+		for( unsigned int i = 0; i < targets.getNumEntities(); i++ )
+			applyEntity(domain, targets.getEntityId(i), targets, i);
+
+		// The encoder will only use baselines which are at least as new as this delta's
+		if( hasBaseline )
+			history->dropBefore(baselineTick);
+		tick = deltaTick;
+
+		return tick;
+	}
+
+
+	Entity* DeltaDecoder::getEntity(EntityId remoteId) {
+		auto iterator = entities.find(remoteId);
+		if( iterator == entities.end() ) return nullptr;
+		return iterator->second;
+	}
+
+
+	unsigned int DeltaDecoder::getTick() {
+		return tick;
+	}
+
+
+	void DeltaDecoder::applyEntity(Domain& domain, EntityId id, const Snapshot& target, int targetIndex) {
+		auto iterator = entities.find(id);
+
+		if( targetIndex < 0 ) {
+			if( iterator != entities.end() ) {
+				iterator->second->destroy();
+				entities.erase(iterator);
+			}
+			history->removeEntity(id);
+			return;
+		}
+
+		const Snapshot& current = history->getCurrent();
+		int currentIndex = current.findEntity(id);
+
+		Entity* entity;
+		if( iterator == entities.end() ) {
+			entity = domain.createEntity();
+			entities.emplace(id, entity);
+			currentIndex = -1;
+		} else {
+			entity = iterator->second;
+		}
+
+		uint64_t currentMask = currentIndex < 0 ? 0 : current.getMask(currentIndex);
+		uint64_t targetMask = target.getMask(targetIndex);
+
+		for( unsigned int typeIndex = 0; typeIndex < types.getNumTypes(); typeIndex++ ) {
+			uint64_t bit = (uint64_t)1 << typeIndex;
+			bool hadComponent = (currentMask & bit) != 0;
+			bool hasComponent = (targetMask & bit) != 0;
+			IReplicatedType* type = types.get(typeIndex);
+
+			if( hadComponent && !hasComponent ) {
+				type->removeComponent(entity);
+			} else if( hasComponent && !hadComponent ) {
+				type->addComponent(entity);
+				type->writeComponent(entity, target.getData(targetIndex, typeIndex));
+			} else if( hasComponent ) {
+				const unsigned char* targetData = target.getData(targetIndex, typeIndex);
+				if( std::memcmp(current.getData(currentIndex, typeIndex), targetData, target.getDataSize(typeIndex)) != 0 )
+					type->writeComponent(entity, targetData);
+			}
+		}
+
+		history->setEntity(id, target, targetIndex);
+	}
+
+}
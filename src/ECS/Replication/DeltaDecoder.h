@@ -0,0 +1,95 @@
+#pragma once
+
+#include <vector>
+#include <memory>
+#include <unordered_map>
+
+#include "ReplicatedType.h"
+#include "Snapshot.h"
+#include "SnapshotHistory.h"
+
+
+namespace River::ECS {
+
+	// Thrown if a delta references a baseline tick the decoder doesn't have
+	class MissingBaselineException : public Exception {
+	public:
+		MissingBaselineException(unsigned int tick) : Exception("Delta baseline tick " + std::to_string(tick) + " is not available") {}
+	};
+
+
+	/**
+	 * @brief	Applies deltas created by a DeltaEncoder onto a Domain. Entities created by the decoder
+	 *			are mapped from the encoding Domain's EntityIds.
+	 *
+	 * @details	Deltas are applied in place on the decoder's current state. For each decoded tick, the decoder keeps
+	 *			the previous state of the entities the tick changed, as the tick may be used as baseline by later
+	 *			deltas. Ticks older than the baseline of the latest decoded delta are dropped.
+	 *
+	 *			Changes are applied as regular Domain operations (creating/destroying entities and adding/removing
+	 *			components), so the Domain must be cleaned between each decode.
+	*/
+	class DeltaDecoder {
+	public:
+
+		DeltaDecoder() {}
+
+
+		/**
+		 * @brief	Registers a component type for replication. Types must be added in the same order as in the encoder.
+		*/
+		template <typename C>
+		void addComponentType() {
+			if( history != nullptr )
+				throw Exception("Component types must be added before decoding");
+			types.add<C>();
+		}
+
+
+		/**
+		 * @brief	Decodes the delta and applies it onto the Domain
+		 * @return	The tick of the delta
+		*/
+		unsigned int decode(Domain& domain, const unsigned char* data, size_t size);
+
+		unsigned int decode(Domain& domain, const std::vector<unsigned char>& data) {
+			return decode(domain, data.data(), data.size());
+		}
+
+
+		/**
+		 * @return	The local Entity created for the encoding Domain's EntityId, or nullptr if it doesn't exist
+		*/
+		Entity* getEntity(EntityId remoteId);
+
+
+		/**
+		 * @return	The tick of the latest applied delta, or Snapshot::NO_TICK if no delta has been applied
+		*/
+		unsigned int getTick();
+
+
+	private:
+		DeltaDecoder(const DeltaDecoder&) = delete;
+		DeltaDecoder& operator=(const DeltaDecoder&) = delete;
+
+		/**
+		 * @brief	Updates the local Entity of the given EntityId from its current state to the state of an entity in
+		 *			the target snapshot (or destroys it if targetIndex is -1)
+		*/
+		void applyEntity(Domain& domain, EntityId id, const Snapshot& target, int targetIndex);
+
+
+	private:
+		ReplicatedTypeSet types;
+
+		std::unique_ptr<SnapshotHistory> history;
+
+		unsigned int tick = Snapshot::NO_TICK;
+
+		/**
+		 * @brief Maps an EntityId of the encoding Domain to the local Entity */
+		std::unordered_map<EntityId, Entity*> entities;
+	};
+
+}
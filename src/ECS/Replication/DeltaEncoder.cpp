@@ -0,0 +1,225 @@
+#include "DeltaEncoder.h"
+
+#include <cstring>
+#include <algorithm>
+#include <unordered_set>
+
+#include "ByteStream.h"
+
+
+namespace River::ECS {
+
+	/**
+	 * @brief	Writes the bytes of current XOR'ed with the bytes of baseline as alternating runs of zero
+	 *			and literal bytes. A null baseline is treated as all zeros.
+	*/
+	static void writeXorRuns(ByteWriter& writer, const unsigned char* current, const unsigned char* baseline, unsigned int size) {
+		auto xorAt = [current, baseline](unsigned int i) -> unsigned char {
+			return baseline == nullptr ? current[i] : (unsigned char)(current[i] ^ baseline[i]);
+		};
+
+		unsigned char literals[256];
+		unsigned int i = 0;
+		while( i < size ) {
+			unsigned int numZeros = 0;
+			while( i < size && xorAt(i) == 0 ) {
+				numZeros++;
+				i++;
+			}
+
+			// A literal run ends at a pair of zero bytes (a single zero is cheaper to keep in the literal)
+			unsigned int numLiterals = 0;
+			while( i < size && numLiterals < sizeof(literals) ) {
+				if( xorAt(i) == 0 && (i + 1 == size || xorAt(i + 1) == 0) ) break;
+				literals[numLiterals++] = xorAt(i);
+				i++;
+			}
+
+			writer.writeVarUInt(numZeros);
+			writer.writeVarUInt(numLiterals);
+			writer.writeBytes(literals, numLiterals);
+		}
+	}
+
+
+	/**
+	 * @brief	Writes the record of an entity whose mask or data differs from the baseline's (a baselineIndex of -1
+	 *			means that the entity doesn't exist in the baseline)
+	 * @return	Whether a record was written
+	*/
+	static bool writeRecord(ByteWriter& writer, EntityId id, const Snapshot& current, unsigned int entityIndex, const Snapshot& baseline, int baselineIndex) {
+		uint64_t mask = current.getMask(entityIndex);
+		uint64_t baselineMask = baselineIndex < 0 ? 0 : baseline.getMask(baselineIndex);
+
+		uint64_t dataMask = 0;
+		for( unsigned int typeIndex = 0; typeIndex < current.getNumTypes(); typeIndex++ ) {
+			if( (mask & ((uint64_t)1 << typeIndex)) == 0 ) continue;
+			const unsigned char* data = current.getData(entityIndex, typeIndex);
+			const unsigned char* baselineData = baselineIndex < 0 ? nullptr : baseline.getData(baselineIndex, typeIndex);
+
+			bool changed;
+			if( baselineData == nullptr ) {
+				changed = false;
+				for( unsigned int i = 0; i < current.getDataSize(typeIndex) && !changed; i++ )
+					changed = data[i] != 0;
+			} else {
+				changed = std::memcmp(data, baselineData, current.getDataSize(typeIndex)) != 0;
+			}
+
+			if( changed )
+				dataMask |= (uint64_t)1 << typeIndex;
+		}
+
+		if( mask == baselineMask && dataMask == 0 ) return false;
+
+		writer.writeVarUInt(id);
+		writer.writeVarUInt(mask);
+		writer.writeVarUInt(dataMask);
+		for( unsigned int typeIndex = 0; typeIndex < current.getNumTypes(); typeIndex++ ) {
+			if( (dataMask & ((uint64_t)1 << typeIndex)) == 0 ) continue;
+			writeXorRuns(
+				writer,
+				current.getData(entityIndex, typeIndex),
+				baselineIndex < 0 ? nullptr : baseline.getData(baselineIndex, typeIndex),
+				current.getDataSize(typeIndex)
+			);
+		}
+		return true;
+	}
+
+
+	std::vector<unsigned char> DeltaEncoder::encode(Domain& domain, unsigned int tick, unsigned int baselineTick) {
+		domain.checkClean("encoding a delta");
+		if( history != nullptr && history->getTick() != Snapshot::NO_TICK && tick < history->getTick() )
+			throw Exception("Ticks must be encoded in increasing order");
+
+		update(domain, tick);
+		const Snapshot& current = history->getCurrent();
+		bool hasBaseline = baselineTick < tick && history->hasTick(baselineTick);
+
+		std::vector<unsigned char> buffer;
+		ByteWriter writer(buffer);
+
+		writer.writeVarUInt(tick);
+		writer.writeVarUInt(hasBaseline ? (uint64_t)baselineTick + 1 : 0);
+
+		std::vector<EntityId> destroyed;
+		std::vector<EntityId> created;
+
+		// Records of entities whose mask or data changed (written to separate buffer, as the count comes first)
+		std::vector<unsigned char> recordBuffer;
+		ByteWriter recordWriter(recordBuffer);
+		unsigned int numRecords = 0;
+
+		if( hasBaseline ) {
+			// Only entities which have changed since the baseline can differ from it
+			std::vector<EntityId> changed;
+			history->forEachChangedSince(baselineTick, [&changed](EntityId id) {
+				changed.push_back(id);
+			});
+			std::sort(changed.begin(), changed.end());
+
+			for( auto id : changed ) {
+				const Snapshot* baseline;
+				int baselineIndex;
+				history->getEntityAt(baselineTick, id, baseline, baselineIndex);
+				int entityIndex = current.findEntity(id);
+
+				if( entityIndex < 0 ) {
+					if( baselineIndex >= 0 )
+						destroyed.push_back(id);
+					continue;
+				}
+				if( baselineIndex < 0 )
+					created.push_back(id);
+				if( writeRecord(recordWriter, id, current, entityIndex, *baseline, baselineIndex) )
+					numRecords++;
+			}
+		} else {
+			for( unsigned int entityIndex = 0; entityIndex < current.getNumEntities(); entityIndex++ ) {
+				EntityId id = current.getEntityId(entityIndex);
+				created.push_back(id);
+				if( writeRecord(recordWriter, id, current, entityIndex, current, -1) )
+					numRecords++;
+			}
+		}
+
+		writer.writeVarUInt(destroyed.size());
+		for( auto id : destroyed )
+			writer.writeVarUInt(id);
+
+		writer.writeVarUInt(created.size());
+		for( auto id : created )
+			writer.writeVarUInt(id);
+
+		writer.writeVarUInt(numRecords);
+		writer.writeBytes(recordBuffer.data(), recordBuffer.size());
+
+		return buffer;
+	}
+
+
+	void DeltaEncoder::acknowledge(unsigned int tick) {
+		if( history != nullptr )
+			history->dropBefore(tick);
+	}
+
+
+	unsigned int DeltaEncoder::getNumSnapshots() {
+		return history == nullptr ? 0 : history->getNumTicks();
+	}
+
+
+	void DeltaEncoder::update(Domain& domain, unsigned int tick) {
+		if( history == nullptr ) {
+			history.reset(new SnapshotHistory(types.getDataSizes()));
+			readBuffer.reset(new Snapshot(Snapshot::NO_TICK, types.getDataSizes()));
+			readBuffer->addEntity(NULL_ENTITY_ID);
+		}
+		history->beginTick(tick);
+
+		if( tracker != nullptr && &tracker->getDomain() == &domain && !tracker->isAllChanged() ) {
+			for( auto id : tracker->getDestroyedEntities() )
+				history->removeEntity(id);
+			for( auto entity : tracker->getChangedEntities() )
+				updateEntity(entity);
+			tracker->reset();
+			return;
+		}
+
+		// Without tracked changes, every entity is compared with the current state
+		if( tracker == nullptr || &tracker->getDomain() != &domain )
+			tracker.reset(new ChangeTracker(domain));
+		tracker->reset();
+
+		std::unordered_set<EntityId> ids;
+		domain.forEachEntity([this, &ids](Entity* entity) {
+			ids.insert(entity->getId());
+			updateEntity(entity);
+		});
+
+		std::vector<EntityId> removed;
+		const Snapshot& current = history->getCurrent();
+		for( unsigned int entityIndex = 0; entityIndex < current.getNumEntities(); entityIndex++ ) {
+			if( ids.count(current.getEntityId(entityIndex)) == 0 )
+				removed.push_back(current.getEntityId(entityIndex));
+		}
+		for( auto id : removed )
+			history->removeEntity(id);
+	}
+
+
+	void DeltaEncoder::updateEntity(Entity* entity) {
+		uint64_t mask = 0;
+		for( unsigned int typeIndex = 0; typeIndex < types.getNumTypes(); typeIndex++ ) {
+			unsigned char* data = readBuffer->getData(0, typeIndex);
+			if( types.get(typeIndex)->readComponent(entity, data) )
+				mask |= (uint64_t)1 << typeIndex;
+			else
+				std::memset(data, 0, readBuffer->getDataSize(typeIndex));
+		}
+		readBuffer->setMask(0, mask);
+		history->setEntity(entity->getId(), *readBuffer, 0);
+	}
+
+}
@@ -0,0 +1,200 @@
+#pragma once
+
+#include <vector>
+#include <cstring>
+#include <type_traits>
+
+#include "ECS/Entity.h"
+#include "Snapshot.h"
+
+
+/**
+ * @brief	Makes only the given fields of the component type be replicated (see River::ECS::ReplicatedFields).
+ *			Must be used in the global namespace:
+ *
+ *			RV_ECS_REPLICATED_FIELDS(Unit, &Unit::position, &Unit::health, &Unit::alive);
+*/
+#define RV_ECS_REPLICATED_FIELDS(C, ...) \
+	namespace River::ECS { template <> struct ReplicatedFields<C> { using Descriptor = Fields<__VA_ARGS__>; }; }
+
+
+namespace River::ECS {
+
+	// Thrown if more component types are registered for replication than a signature mask can hold
+	class MaxReplicatedTypesException : public Exception {
+	public:
+		MaxReplicatedTypesException() : Exception("Max number of replicated component types (" + std::to_string(Snapshot::MAX_TYPES) + ") has been reached") {}
+	};
+
+
+	/**
+	 * @brief	Describes which bytes of a component type are replicated. By default, all bytes after the Component
+	 *			base are, which includes any padding between and after the fields. Padding has indeterminate values,
+	 *			which would show up as changes in the deltas, so types with padding should list their fields with
+	 *			RV_ECS_REPLICATED_FIELDS: only the listed fields are replicated, packed one after another.
+	*/
+	template <typename C>
+	struct ReplicatedFields {
+		using Descriptor = void;
+	};
+
+
+	template <typename C, typename Descriptor = typename ReplicatedFields<C>::Descriptor>
+	struct ReplicatedData;
+
+	/**
+	 * @brief	Replicates all bytes after the Component base, so the controller's ComponentId is never overwritten
+	*/
+	template <typename C>
+	struct ReplicatedData<C, void> {
+		static_assert(std::is_trivially_copyable<C>::value, "Replicated component type must be trivially copyable");
+
+		const static unsigned int OFFSET = sizeof(Component);
+		const static unsigned int SIZE = sizeof(C) - OFFSET;
+
+		static void read(const C& component, unsigned char* data) {
+			std::memcpy(data, (const unsigned char*)&component + OFFSET, SIZE);
+		}
+
+		static void write(C& component, const unsigned char* data) {
+			std::memcpy((unsigned char*)&component + OFFSET, data, SIZE);
+		}
+	};
+
+	/**
+	 * @brief	Replicates the listed fields, packed without padding in the order they are listed
+	*/
+	template <typename C, auto ... F>
+	struct ReplicatedData<C, Fields<F...>> {
+		static_assert((std::is_same<typename MemberPointerTraits<decltype(F)>::Class, C>::value && ...), "Replicated fields must be members of the component type");
+		static_assert((std::is_trivially_copyable<FieldType<F>>::value && ...), "Replicated fields must be trivially copyable");
+
+		const static unsigned int SIZE = (0 + ... + (unsigned int)sizeof(FieldType<F>));
+
+		static void read(const C& component, unsigned char* data) {
+			((std::memcpy(data, &(component.*F), sizeof(FieldType<F>)), data += sizeof(FieldType<F>)), ...);
+		}
+
+		static void write(C& component, const unsigned char* data) {
+			((std::memcpy(&(component.*F), data, sizeof(FieldType<F>)), data += sizeof(FieldType<F>)), ...);
+		}
+	};
+
+
+	/**
+	 * @brief	Type-erased access to the replicated bytes of one component type
+	*/
+	class IReplicatedType {
+	public:
+		virtual ~IReplicatedType() {}
+
+		/**
+		 * @return	Number of bytes replicated per component (see ReplicatedFields)
+		*/
+		virtual unsigned int getDataSize() const = 0;
+
+		/**
+		 * @brief	Copies the replicated bytes of the Entity's component into data, if it has a component of this type
+		 * @return	Whether the Entity has a component of this type
+		*/
+		virtual bool readComponent(Entity* entity, unsigned char* data) = 0;
+
+		virtual void addComponent(Entity* entity) = 0;
+		virtual void removeComponent(Entity* entity) = 0;
+
+		/**
+		 * @brief	Overwrites the replicated bytes of the Entity's component with the given data
+		*/
+		virtual void writeComponent(Entity* entity, const unsigned char* data) = 0;
+	};
+
+
+	template <typename C>
+	class ReplicatedType : public IReplicatedType {
+		RV_ECS_ASSERT_COMPONENT_TYPE(C);
+		static_assert(!ComponentFields<C>::IS_SOA, "Replicated component type can't be stored as a structure of arrays");
+
+		using Data = ReplicatedData<C>;
+
+	public:
+
+		unsigned int getDataSize() const override {
+			return Data::SIZE;
+		}
+
+
+		bool readComponent(Entity* entity, unsigned char* data) override {
+			// Getting the component would give the Domain a signature bit for the type, even if it never uses it
+			if( !entity->getDomain().usesComponentType<C>() ) return false;
+			C* component = entity->getComponent<C>();
+			if( component == nullptr ) return false;
+			Data::read(*component, data);
+			return true;
+		}
+
+
+		void addComponent(Entity* entity) override {
+			entity->addComponent<C>();
+		}
+
+
+		void removeComponent(Entity* entity) override {
+			entity->removeComponent<C>();
+		}
+
+
+		void writeComponent(Entity* entity, const unsigned char* data) override {
+			Data::write(*entity->getComponent<C>(), data);
+		}
+	};
+
+
+
+	/**
+	 * @brief	Ordered list of the component types which are replicated. The encoder and the decoder
+	 *			must register the same types in the same order, as the index is used on the wire.
+	*/
+	class ReplicatedTypeSet {
+	public:
+
+		ReplicatedTypeSet() {}
+
+		~ReplicatedTypeSet() {
+			for( auto type : types )
+				delete type;
+		}
+
+
+		template <typename C>
+		void add() {
+			if( types.size() >= Snapshot::MAX_TYPES )
+				throw MaxReplicatedTypesException();
+			types.push_back(new ReplicatedType<C>());
+			dataSizes.push_back(types.back()->getDataSize());
+		}
+
+
+		IReplicatedType* get(unsigned int typeIndex) const {
+			return types.at(typeIndex);
+		}
+
+
+		unsigned int getNumTypes() const {
+			return (unsigned int)types.size();
+		}
+
+
+		const std::vector<unsigned int>& getDataSizes() const {
+			return dataSizes;
+		}
+
+
+	private:
+		ReplicatedTypeSet(const ReplicatedTypeSet&) = delete;
+		ReplicatedTypeSet& operator=(const ReplicatedTypeSet&) = delete;
+
+		std::vector<IReplicatedType*> types;
+		std::vector<unsigned int> dataSizes;
+	};
+
+}
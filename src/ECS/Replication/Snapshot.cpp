@@ -0,0 +1,88 @@
+#include "Snapshot.h"
+
+#include <cstring>
+
+
+namespace River::ECS {
+
+	Snapshot::Snapshot(unsigned int tick, const std::vector<unsigned int>& dataSizes) :
+		tick(tick), dataSizes(dataSizes), data(dataSizes.size())
+	{}
+
+
+	unsigned int Snapshot::addEntity(EntityId id) {
+		unsigned int entityIndex = (unsigned int)entityIds.size();
+		entityIds.push_back(id);
+		masks.push_back(0);
+		entityIndices[id] = entityIndex;
+
+		// New data is value-initialized (zeroed)
+		for( unsigned int typeIndex = 0; typeIndex < data.size(); typeIndex++ )
+			data[typeIndex].resize(data[typeIndex].size() + dataSizes[typeIndex]);
+
+		return entityIndex;
+	}
+
+
+	void Snapshot::removeEntity(EntityId id) {
+		auto iterator = entityIndices.find(id);
+		if( iterator == entityIndices.end() ) return;
+
+		unsigned int entityIndex = iterator->second;
+		unsigned int lastIndex = (unsigned int)entityIds.size() - 1;
+		entityIndices.erase(iterator);
+
+		if( entityIndex != lastIndex ) {
+			// Move last entity into the removed entity's slot
+			entityIds[entityIndex] = entityIds[lastIndex];
+			masks[entityIndex] = masks[lastIndex];
+			entityIndices[entityIds[entityIndex]] = entityIndex;
+			for( unsigned int typeIndex = 0; typeIndex < data.size(); typeIndex++ )
+				std::memcpy(getData(entityIndex, typeIndex), getData(lastIndex, typeIndex), dataSizes[typeIndex]);
+		}
+
+		entityIds.pop_back();
+		masks.pop_back();
+		// Erasing the last entity's range (rather than resizing to size - dataSize) doesn't make the compiler
+		// assume that the size may wrap around
+		for( unsigned int typeIndex = 0; typeIndex < data.size(); typeIndex++ )
+			data[typeIndex].erase(data[typeIndex].end() - dataSizes[typeIndex], data[typeIndex].end());
+	}
+
+
+	int Snapshot::findEntity(EntityId id) const {
+		auto iterator = entityIndices.find(id);
+		if( iterator == entityIndices.end() ) return -1;
+		return (int)iterator->second;
+	}
+
+
+	void Snapshot::setMask(unsigned int entityIndex, uint64_t mask) {
+		uint64_t removed = masks[entityIndex] & ~mask;
+		for( unsigned int typeIndex = 0; typeIndex < data.size(); typeIndex++ ) {
+			if( removed & ((uint64_t)1 << typeIndex) )
+				std::memset(getData(entityIndex, typeIndex), 0, dataSizes[typeIndex]);
+		}
+		masks[entityIndex] = mask;
+	}
+
+
+	void Snapshot::copyEntity(unsigned int entityIndex, const Snapshot& source, unsigned int sourceIndex) {
+		masks[entityIndex] = source.masks[sourceIndex];
+		for( unsigned int typeIndex = 0; typeIndex < data.size(); typeIndex++ )
+			std::memcpy(getData(entityIndex, typeIndex), source.getData(sourceIndex, typeIndex), dataSizes[typeIndex]);
+	}
+
+
+	bool Snapshot::equalsEntity(unsigned int entityIndex, const Snapshot& source, unsigned int sourceIndex) const {
+		if( masks[entityIndex] != source.masks[sourceIndex] )
+			return false;
+		// Data of missing components is zero in both, so it doesn't have to be skipped
+		for( unsigned int typeIndex = 0; typeIndex < data.size(); typeIndex++ ) {
+			if( std::memcmp(getData(entityIndex, typeIndex), source.getData(sourceIndex, typeIndex), dataSizes[typeIndex]) != 0 )
+				return false;
+		}
+		return true;
+	}
+
+}
@@ -0,0 +1,100 @@
+#include "SnapshotHistory.h"
+
+#include <algorithm>
+
+
+namespace River::ECS {
+
+	SnapshotHistory::SnapshotHistory(const std::vector<unsigned int>& dataSizes) :
+		dataSizes(dataSizes), current(Snapshot::NO_TICK, dataSizes)
+	{}
+
+
+	void SnapshotHistory::beginTick(unsigned int tick) {
+		if( changes.find(tick) == changes.end() )
+			changes.emplace(tick, Changes(dataSizes));
+		current.setTick(tick);
+	}
+
+
+	bool SnapshotHistory::setEntity(EntityId id, const Snapshot& source, unsigned int sourceIndex) {
+		int entityIndex = current.findEntity(id);
+		if( entityIndex >= 0 && current.equalsEntity(entityIndex, source, sourceIndex) )
+			return false;
+
+		recordPrevious(id);
+		if( entityIndex < 0 )
+			entityIndex = current.addEntity(id);
+		current.copyEntity(entityIndex, source, sourceIndex);
+		return true;
+	}
+
+
+	bool SnapshotHistory::removeEntity(EntityId id) {
+		if( current.findEntity(id) < 0 )
+			return false;
+		recordPrevious(id);
+		current.removeEntity(id);
+		return true;
+	}
+
+
+	void SnapshotHistory::getEntityAt(unsigned int tick, EntityId id, const Snapshot*& snapshot, int& index) const {
+		// The state before the first change after the tick is the state at the tick
+		for( auto iterator = changes.upper_bound(tick); iterator != changes.end(); iterator++ ) {
+			const Changes& tickChanges = iterator->second;
+			index = tickChanges.previous.findEntity(id);
+			if( index >= 0 ) {
+				snapshot = &tickChanges.previous;
+				return;
+			}
+			if( tickChanges.created.count(id) > 0 ) {
+				snapshot = &tickChanges.previous;
+				index = -1;
+				return;
+			}
+		}
+
+		// Unchanged since the tick
+		snapshot = &current;
+		index = current.findEntity(id);
+	}
+
+
+	void SnapshotHistory::forEachChangedSince(unsigned int tick, std::function<void(EntityId)> callback) const {
+		std::unordered_set<EntityId> visited;
+		for( auto iterator = changes.upper_bound(tick); iterator != changes.end(); iterator++ ) {
+			const Changes& tickChanges = iterator->second;
+			for( unsigned int i = 0; i < tickChanges.previous.getNumEntities(); i++ ) {
+				if( visited.insert(tickChanges.previous.getEntityId(i)).second )
+					callback(tickChanges.previous.getEntityId(i));
+			}
+			for( auto id : tickChanges.created ) {
+				if( visited.insert(id).second )
+					callback(id);
+			}
+		}
+	}
+
+
+	void SnapshotHistory::dropBefore(unsigned int tick) {
+		// The current tick is kept, as changes are still recorded into it
+		changes.erase(changes.begin(), changes.lower_bound(std::min(tick, current.getTick())));
+	}
+
+
+	void SnapshotHistory::recordPrevious(EntityId id) {
+		Changes& tickChanges = changes.at(current.getTick());
+		if( tickChanges.previous.findEntity(id) >= 0 || tickChanges.created.count(id) > 0 )
+			return;
+
+		int entityIndex = current.findEntity(id);
+		if( entityIndex < 0 ) {
+			tickChanges.created.insert(id);
+		} else {
+			unsigned int previousIndex = tickChanges.previous.addEntity(id);
+			tickChanges.previous.copyEntity(previousIndex, current, entityIndex);
+		}
+	}
+
+}
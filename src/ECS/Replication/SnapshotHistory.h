@@ -0,0 +1,123 @@
+#pragma once
+
+#include <vector>
+#include <map>
+#include <unordered_set>
+#include <functional>
+
+#include "Snapshot.h"
+
+
+namespace River::ECS {
+
+	/**
+	 * @brief	The current replicated state, along with what each entity looked like before it was changed in each
+	 *			tick. This gives the state of any changed entity at a previous tick, without storing a full snapshot
+	 *			of each tick.
+	 *
+	 * @details	Changes are made to the current state through setEntity() and removeEntity(), which record the
+	 *			entity's previous state the first time it's changed in the current tick.
+	*/
+	class SnapshotHistory {
+	public:
+
+		/**
+		 * @param dataSizes		Number of bytes per component of each replicated type
+		*/
+		SnapshotHistory(const std::vector<unsigned int>& dataSizes);
+
+
+		/**
+		 * @brief	Starts recording changes as the given tick, which must not be older than the current tick
+		*/
+		void beginTick(unsigned int tick);
+
+
+		/**
+		 * @brief	Sets the entity's mask and data to those of an entity in the source snapshot, adding the entity if
+		 *			it doesn't exist
+		 * @return	Whether the entity changed
+		*/
+		bool setEntity(EntityId id, const Snapshot& source, unsigned int sourceIndex);
+
+		/**
+		 * @brief	Removes the entity from the current state
+		 * @return	Whether the entity existed
+		*/
+		bool removeEntity(EntityId id);
+
+
+		/**
+		 * @brief	Finds the state of an entity at the end of the given tick
+		 * @param snapshot	Set to the snapshot which holds the entity's state
+		 * @param index		Set to the entity's index in the snapshot, or -1 if it didn't exist at the tick
+		*/
+		void getEntityAt(unsigned int tick, EntityId id, const Snapshot*& snapshot, int& index) const;
+
+		/**
+		 * @brief	Calls the callback once for each entity which has changed in the ticks after the given tick
+		*/
+		void forEachChangedSince(unsigned int tick, std::function<void(EntityId)> callback) const;
+
+
+		/**
+		 * @return	Whether changes of the tick are recorded (i.e. whether the tick can be used with getEntityAt())
+		*/
+		bool hasTick(unsigned int tick) const {
+			return changes.find(tick) != changes.end();
+		}
+
+		/**
+		 * @brief	Drops the changes of all ticks older than the given tick
+		*/
+		void dropBefore(unsigned int tick);
+
+		unsigned int getNumTicks() const {
+			return (unsigned int)changes.size();
+		}
+
+
+		const Snapshot& getCurrent() const {
+			return current;
+		}
+
+		/**
+		 * @return	The tick which changes are recorded as, or Snapshot::NO_TICK if no tick has begun
+		*/
+		unsigned int getTick() const {
+			return current.getTick();
+		}
+
+
+	private:
+
+		/**
+		 * @brief	Records the entity's current state as its state before the current tick, unless it has already
+		 *			been recorded in this tick
+		*/
+		void recordPrevious(EntityId id);
+
+		/**
+		 * @brief The changes made in one tick */
+		struct Changes {
+			Changes(const std::vector<unsigned int>& dataSizes) : previous(Snapshot::NO_TICK, dataSizes) {}
+
+			/**
+			 * @brief State of the changed entities before the tick */
+			Snapshot previous;
+
+			/**
+			 * @brief Changed entities which didn't exist before the tick */
+			std::unordered_set<EntityId> created;
+		};
+
+
+	private:
+		std::vector<unsigned int> dataSizes;
+
+		Snapshot current;
+
+		std::map<unsigned int, Changes> changes;
+	};
+
+}
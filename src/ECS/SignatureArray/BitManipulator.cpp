@@ -11,71 +11,132 @@ namespace River::ECS {
 	void BitManipulator::setData(unsigned char* data, unsigned int numBits) {
 		bits = data;
 		size = numBits;
-		parts = 1 + (numBits - 1) / 8;
-		dirty = true;
+		parts = (numBits + 7) / 8;
+		checkBits();
 	}
 
 
-	bool BitManipulator::get(unsigned int i) const {
-		if( !(i < size) )
-			throw std::out_of_range(("Bit index out of range (i=" + std::to_string(i) + ", size=" + std::to_string(size) + ")").c_str());
+	void BitManipulator::setDataPointer(unsigned char* data) {
+		bits = data;
+	}
 
-		unsigned int partIndex = i / 8;
-		unsigned int bit = i % 8;
 
-		unsigned char mask = 1 << bit;
-		unsigned char& part = *(bits + partIndex);
-		return part & 1 << bit;
+	void BitManipulator::setNumBits(unsigned int numBits) {
+		size = numBits;
+		parts = (numBits + 7) / 8;
+
+		// Summary bits of words which are added or removed are always 0
+		unsigned int newSummaryWords = (BitOperations::numWords(parts) + 63) / 64;
+		if( newSummaryWords == summaryWords ) return;
+
+		uint64_t firstSummaryWord = summaryWords == 0 ? 0 : getSummary()[0];
+		if( newSummaryWords <= 1 ) {
+			summary.clear();
+			inlineSummary = newSummaryWords == 0 ? 0 : firstSummaryWord;
+		} else if( summaryWords <= 1 ) {
+			summary.assign(newSummaryWords, 0);
+			summary[0] = firstSummaryWord;
+		} else {
+			summary.resize(newSummaryWords, 0);
+		}
+		summaryWords = newSummaryWords;
 	}
 
 
-	void BitManipulator::set(unsigned int i) {
+	bool BitManipulator::get(unsigned int i) const {
 		if( !(i < size) )
 			throw std::out_of_range(("Bit index out of range (i=" + std::to_string(i) + ", size=" + std::to_string(size) + ")").c_str());
+		return getUnchecked(i);
+	}
 
-		unsigned int partIndex = i / 8;
-		unsigned int bit = i % 8;
 
-		unsigned char& part = *(bits + partIndex);
-		part = part | ((unsigned char)1) << bit;
-		dirty = true;
+	void BitManipulator::set(unsigned int i) {
+		if( !(i < size) )
+			throw std::out_of_range(("Bit index out of range (i=" + std::to_string(i) + ", size=" + std::to_string(size) + ")").c_str());
+		setUnchecked(i);
 	}
 
 
 	void BitManipulator::unset(unsigned int i) {
 		if( !(i < size) )
 			throw std::out_of_range(("Bit index out of range (i=" + std::to_string(i) + ", size=" + std::to_string(size) + ")").c_str());
+		unsetUnchecked(i);
+	}
 
-		unsigned int partIndex = i / 8;
-		unsigned int bit = i % 8;
 
-		unsigned char& part = *(bits + partIndex);
+	void BitManipulator::setUnchecked(unsigned int i) {
+		unsigned char& part = bits[i >> 3];
+		unsigned char mask = (unsigned char)(1 << (i & 7));
+		if( part & mask ) return;
 
-		part = part & ~(((unsigned char)1) << bit);
-		dirty = true;
-	}
+		part |= mask;
+		bitsSet++;
+		getSummary()[i / 4096] |= (uint64_t)1 << ((i / 64) % 64);
 
-	void BitManipulator::unsetAll() {
-		for( unsigned int i = 0; i < parts; i++ )
-			bits[i] = 0;
-		firstBit = -1;
-		lastBit = -1;
-		dirty = false;
+		if( firstBit < 0 || (int)i < firstBit ) firstBit = i;
+		if( (int)i > lastBit ) lastBit = i;
 	}
 
-	int BitManipulator::getFirstSetBit() {
-		if( dirty ) checkBits();
-		return firstBit;
+
+	void BitManipulator::unsetUnchecked(unsigned int i) {
+		unsigned char& part = bits[i >> 3];
+		unsigned char mask = (unsigned char)(1 << (i & 7));
+		if( !(part & mask) ) return;
+
+		part &= (unsigned char)~mask;
+		bitsSet--;
+		updateSummary(i >> 3);
+
+		if( bitsSet == 0 ) {
+			firstBit = -1;
+			lastBit = -1;
+			return;
+		}
+		if( (int)i == firstBit ) firstBit = findFirstSetBit(i / 64);
+		if( (int)i == lastBit ) lastBit = findLastSetBit(i / 64);
 	}
 
-	int BitManipulator::getLastSetBit() {
-		if( dirty ) checkBits();
-		return lastBit;
+
+	void BitManipulator::setPart(unsigned int partIndex, unsigned char value) {
+		unsigned char previous = bits[partIndex];
+		if( previous == value ) return;
+
+		bits[partIndex] = value;
+		bitsSet = bitsSet - BitOperations::countSetBits(previous) + BitOperations::countSetBits(value);
+		updateSummary(partIndex);
+
+		if( bitsSet == 0 ) {
+			firstBit = -1;
+			lastBit = -1;
+			return;
+		}
+
+		int lowestBit = partIndex * 8;
+		int highestBit = lowestBit + 7;
+
+		if( value != 0 ) {
+			int lowestSet = lowestBit + BitOperations::countTrailingZeros(value);
+			int highestSet = lowestBit + BitOperations::highestSetBit(value);
+			if( firstBit < 0 || lowestSet < firstBit ) firstBit = lowestSet;
+			if( highestSet > lastBit ) lastBit = highestSet;
+		}
+
+		// The first or last bit may have been unset
+		if( firstBit >= lowestBit && firstBit <= highestBit && !getUnchecked(firstBit) )
+			firstBit = findFirstSetBit(partIndex / 8);
+		if( lastBit >= lowestBit && lastBit <= highestBit && !getUnchecked(lastBit) )
+			lastBit = findLastSetBit(partIndex / 8);
 	}
 
-	unsigned int BitManipulator::getBitsSet() {
-		if( dirty ) checkBits();
-		return bitsSet;
+
+	void BitManipulator::unsetAll() {
+		for( unsigned int i = 0; i < parts; i++ )
+			bits[i] = 0;
+		for( unsigned int i = 0; i < summaryWords; i++ )
+			getSummary()[i] = 0;
+		bitsSet = 0;
+		firstBit = -1;
+		lastBit = -1;
 	}
 
 	unsigned char* BitManipulator::getBits() {
@@ -88,58 +149,90 @@ namespace River::ECS {
 
 	
 	void BitManipulator::forEachSetBit(std::function<void(unsigned int)> callback) {
-		if( dirty ) checkBits();
-
 		// No need to iterate if no bits are set
 		if( bitsSet == 0 ) return;
 
-		// Limit the iteration interval to parts with bits set
-		unsigned int firstPart = firstBit / 8;
-		unsigned int lastPart = lastBit / 8;
-
-		// Iterate over each part (byte / unsigned char)
-		for( unsigned int i = firstPart; i <= lastPart; i++ ) {
-			unsigned char part = bits[i];
-			if( part == 0 ) continue; // No bits are set, so no need to check
-
-			unsigned char mask = 1; // Determines which bit we are looking at 
-			for( int j = 0; j < 8; j++ ) {
-				// Check if bit is set
-				if( (part & mask) ) {
-					int bitIndex = i * 8 + j;
-					callback(bitIndex ); 
+		const uint64_t* summaryData = getSummary();
+		unsigned int firstSummaryWord = firstBit / 4096;
+		unsigned int lastSummaryWord = lastBit / 4096;
+
+		// Only words with bits set are visited
+		for( unsigned int i = firstSummaryWord; i <= lastSummaryWord; i++ ) {
+			uint64_t summaryWord = summaryData[i];
+			while( summaryWord != 0 ) {
+				unsigned int wordIndex = i * 64 + BitOperations::countTrailingZeros(summaryWord);
+				uint64_t word = BitOperations::loadWord(bits, parts, wordIndex);
+
+				// Visit the lowest set bit, and clear it, until no bits are left
+				while( word != 0 ) {
+					callback(wordIndex * 64 + BitOperations::countTrailingZeros(word));
+					word &= word - 1;
 				}
-				mask = mask << 1;
+				summaryWord &= summaryWord - 1;
 			}
 		}
 	}
 
-	/**
-	 * @brief	Finds the first bit, last bit and the number of bits set in this signature
-	*/
+
 	void BitManipulator::checkBits() {
 		firstBit = -1;
 		lastBit = -1;
 		bitsSet = 0;
 
-		// Iterate over each part (byte / unsigned char)
-		for( unsigned int i = 0; i < parts; i++ ) {
-			unsigned char part = bits[i];
-			if( part == 0 ) continue; // No bits are set, so no need to check
-
-			unsigned char mask = 1; // Determines which bit we are looking at 
-			for( int j = 0; j < 8; j++ ) {
-				// Check if bit is set
-				if( (part & mask) ) {
-					int bitIndex = i * 8 + j;
-					if( firstBit < 0 ) firstBit = bitIndex;
-					lastBit = bitIndex;
-					bitsSet++;
-				}
-				mask = mask << 1;
-			}
+		// Rebuild summary from scratch
+		unsigned int numBits = size;
+		setNumBits(0);
+		setNumBits(numBits);
+
+		unsigned int numWords = BitOperations::numWords(parts);
+		uint64_t* summaryData = getSummary();
+		for( unsigned int i = 0; i < numWords; i++ ) {
+			uint64_t word = BitOperations::loadWord(bits, parts, i);
+			if( word == 0 ) continue;
+
+			if( firstBit < 0 ) firstBit = i * 64 + BitOperations::countTrailingZeros(word);
+			lastBit = i * 64 + BitOperations::highestSetBit(word);
+			bitsSet += BitOperations::countSetBits(word);
+			summaryData[i / 64] |= (uint64_t)1 << (i % 64);
+		}
+	}
+
+
+	void BitManipulator::updateSummary(unsigned int partIndex) {
+		unsigned int wordIndex = partIndex / 8;
+		uint64_t mask = (uint64_t)1 << (wordIndex % 64);
+		if( BitOperations::loadWord(bits, parts, wordIndex) != 0 )
+			getSummary()[wordIndex / 64] |= mask;
+		else
+			getSummary()[wordIndex / 64] &= ~mask;
+	}
+
+
+	int BitManipulator::findFirstSetBit(unsigned int wordIndex) const {
+		const uint64_t* summaryData = getSummary();
+		unsigned int summaryIndex = wordIndex / 64;
+		uint64_t summaryWord = summaryData[summaryIndex] & (~(uint64_t)0 << (wordIndex % 64));
+		while( summaryWord == 0 ) {
+			if( ++summaryIndex >= summaryWords ) return -1;
+			summaryWord = summaryData[summaryIndex];
 		}
-		dirty = false;
+
+		unsigned int firstWord = summaryIndex * 64 + BitOperations::countTrailingZeros(summaryWord);
+		return firstWord * 64 + BitOperations::countTrailingZeros(BitOperations::loadWord(bits, parts, firstWord));
+	}
+
+
+	int BitManipulator::findLastSetBit(unsigned int wordIndex) const {
+		const uint64_t* summaryData = getSummary();
+		int summaryIndex = wordIndex / 64;
+		uint64_t summaryWord = summaryData[summaryIndex] & (~(uint64_t)0 >> (63 - wordIndex % 64));
+		while( summaryWord == 0 ) {
+			if( --summaryIndex < 0 ) return -1;
+			summaryWord = summaryData[summaryIndex];
+		}
+
+		unsigned int lastWord = summaryIndex * 64 + BitOperations::highestSetBit(summaryWord);
+		return lastWord * 64 + BitOperations::highestSetBit(BitOperations::loadWord(bits, parts, lastWord));
 	}
 
-}
\ No newline at end of file
+}
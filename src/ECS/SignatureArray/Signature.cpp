@@ -1,64 +1,120 @@
 #include "Signature.h"
 
+#include <cstring>
+
 namespace River::ECS {
 
 
 	Signature::Signature(unsigned int size) :
-		BitManipulator((unsigned char*) calloc( (1+(size-1)/8), 1), size)
-	{}
+		BitManipulator(nullptr, 0)
+	{
+		unsigned int numParts = (size + 7) / 8;
+		setDataPointer(allocate(numParts));
+		std::memset(bits, 0, numParts);
+		setNumBits(size);
+	}
 
 	Signature::~Signature() {
-		free(bits);
+		release();
 	}
 
 
 	Signature& Signature::operator=(const Signature& other)	{
-		free(bits);
-		firstBit = other.firstBit;
-		lastBit = other.lastBit;
-		bitsSet = other.bitsSet;
-		dirty = other.dirty;
-		size = other.size;
-		parts = other.parts;
-		bits = (unsigned char*)calloc(parts, 1);
-		for( unsigned int i = 0; i < parts; i++ )
-			bits[i] = other.bits[i];
+		if( this == &other ) return *this;
+
+		// Heap memory is reused if it's large enough
+		unsigned char* data = bits;
+		if( isInline() || other.parts > parts ) {
+			release();
+			data = allocate(other.parts);
+		}
+
+		BitManipulator::operator=(other);
+		bits = data;
+		std::memcpy(bits, other.bits, parts);
 		return *this;
 	}
 
 
 	Signature::Signature(const Signature& other) :
-		BitManipulator((unsigned char*) calloc(other.parts, 1), other.size)
+		BitManipulator(other)
+	{
+		bits = allocate(other.parts);
+		std::memcpy(bits, other.bits, parts);
+	}
+
+
+	Signature& Signature::operator=(Signature&& other) noexcept {
+		if( this == &other ) return *this;
+
+		if( other.isInline() ) {
+			release();
+			BitManipulator::operator=(std::move(other));
+			bits = inlineBits;
+			std::memcpy(bits, other.inlineBits, parts);
+			return *this;
+		}
+
+		// Take the other signature's heap memory, and leave it empty
+		release();
+		BitManipulator::operator=(std::move(other));
+		other.setData(other.inlineBits, 0);
+		return *this;
+	}
+
+
+	Signature::Signature(Signature&& other) noexcept :
+		BitManipulator(nullptr, 0)
 	{
-		firstBit = other.firstBit;
-		lastBit = other.lastBit;
-		bitsSet = other.bitsSet;
-		dirty = other.dirty;
+		bits = inlineBits;
+		*this = std::move(other);
+	}
 
-		for( unsigned int i = 0; i < parts; i++ )
-			bits[i] = other.bits[i];
+
+	bool Signature::operator==(const Signature& other) const {
+		return size == other.size && std::memcmp(bits, other.bits, parts) == 0;
 	}
 
 
+	bool Signature::operator!=(const Signature& other) const {
+		return !(*this == other);
+	}
+
 
 	void Signature::resize(unsigned int newSize) {
 		if( newSize == size ) return;
-		if( newSize < size ) throw new SignatureSizeReducedException(size, newSize);
-
-		size = newSize;
+		if( newSize < size ) throw SignatureSizeReducedException(size, newSize);
 
 		// Check new memory size
-		unsigned int newParts = 1 + (newSize - 1) / 8;
-		if( newParts == parts ) return;
-
-		// Reallocate memory and initialize data to 0
-		bits = (unsigned char*) realloc(bits, newParts);
-		unsigned int firstNewByte = parts;
-		for( unsigned int i = parts; i < newParts; i++ ) {
-			bits[i] = 0;
+		unsigned int newParts = (newSize + 7) / 8;
+		if( newParts != parts ) {
+			if( isInline() ) {
+				if( newParts > sizeof(inlineBits) ) {
+					unsigned char* newBits = (unsigned char*) malloc(newParts);
+					std::memcpy(newBits, inlineBits, parts);
+					setDataPointer(newBits);
+				}
+			} else {
+				setDataPointer((unsigned char*) realloc(bits, newParts));
+			}
+
+			// Initialize new data to 0
+			std::memset(bits + parts, 0, newParts - parts);
 		}
 
-		parts = newParts;
+		setNumBits(newSize);
+	}
+
+
+	unsigned char* Signature::allocate(unsigned int numParts) {
+		return numParts <= sizeof(inlineBits) ? inlineBits : (unsigned char*) malloc(numParts);
+	}
+
+
+	void Signature::release() {
+		if( !isInline() )
+			free(bits);
+		bits = inlineBits;
 	}
 
 }
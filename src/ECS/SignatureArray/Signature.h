@@ -14,17 +14,31 @@ namespace River::ECS {
 	};
 
 	/**
-	 * @brief Data is heap allocated, so it's not efficient to copy this
+	 * @brief	Signatures of up to INLINE_BITS bits are stored within the object, so creating, copying and moving
+	 *			these doesn't allocate memory. Larger signatures are heap allocated.
 	*/
 	class Signature : public BitManipulator {
 	public:
 
+		/**
+		 * @brief Max number of bits which are stored without heap allocating */
+		inline static const unsigned int INLINE_BITS = 256;
+
 		Signature(unsigned int size);
 		~Signature();
 
 		Signature& operator=(const Signature& other);
 		Signature(const Signature& other);
 
+		Signature& operator=(Signature&& other) noexcept;
+		Signature(Signature&& other) noexcept;
+
+		/**
+		 * @return	Whether the signatures have the same size and the same bits set
+		*/
+		bool operator==(const Signature& other) const;
+		bool operator!=(const Signature& other) const;
+
 		/**
 		 * @brief	Resizes the number of elements (bits) this signature may hold. This may reallocate the signatures memory, in
 					case the current allocated memory can't hold the new number of elements
@@ -32,8 +46,28 @@ namespace River::ECS {
 		*/
 		void resize(unsigned int newSize);
 
-	};
-}
 
+	private:
+
+		/**
+		 * @return	Whether the bits are stored in inlineBits (rather than on the heap)
+		*/
+		bool isInline() const {
+			return bits == inlineBits;
+		}
+
+		/**
+		 * @return	Inline memory if the number of parts (bytes) fit, otherwise uninitialized heap memory
+		*/
+		unsigned char* allocate(unsigned int numParts);
+
+		/**
+		 * @brief	Frees heap memory if there is any
+		*/
+		void release();
 
 
+	private:
+		unsigned char inlineBits[INLINE_BITS / 8];
+	};
+}
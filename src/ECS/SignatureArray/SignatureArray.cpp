@@ -3,6 +3,8 @@
 #include <vector>
 #include <functional>
 #include <sstream>
+#include <cstring>
+#include <algorithm>
 
 #include "SignatureArray.h"
 
@@ -10,14 +12,17 @@
 namespace River::ECS {
 
 
-	SignatureArray::SignatureArray(unsigned int memoryStepSize) : memoryStepSize(memoryStepSize) {
-		reserveMemory(memoryStepSize);
+	SignatureArray::SignatureArray(unsigned int memoryStepSize, std::pmr::memory_resource* memoryResource, SignatureLayout layout) :
+		memoryResource(memoryResource), layout(layout), memoryStepSize(memoryStepSize), entities(memoryResource), columns(memoryResource)
+	{
+		if( layout == SignatureLayout::RowMajor )
+			reserveMemory(memoryStepSize);
 	}
 
 
 	SignatureArray::~SignatureArray() {
 		if( data != nullptr )
-			free(data);
+			memoryResource->deallocate(data, memorySize, alignof(uint64_t));
 	}
 
 
@@ -29,46 +34,62 @@ namespace River::ECS {
 		* The signature size is not altered.
 	*/
 	void SignatureArray::clear() {
-		free(data);
+		if( data != nullptr )
+			memoryResource->deallocate(data, memorySize, alignof(uint64_t));
 		data = nullptr;
 		numSignatures = 0;
 		memorySize = 0;
+		entities.clear();
+
+		columnWords = 0;
+		resizeColumnCapacity(0);
 	}
 
 
 	void SignatureArray::forMatchingSignatures(Signature& signature, std::function<void(unsigned int signatureIndex)> callback) {
-		/*	There is no reason to check parts if they are all 0's, so we skip ahead and cut off the end */
-		unsigned int firstPartIndex = signature.getFirstSetBit() < 0 ? 0 : signature.getFirstSetBit() / 8;
-		unsigned int lastPartIndex = signature.getLastSetBit() < 0 ? 0 : signature.getLastSetBit() / 8;
+		// All signatures match an empty query
+		if( signature.getBitsSet() == 0 ) {
+			for( unsigned int signatureIndex = 0; signatureIndex < numSignatures; signatureIndex++ )
+				callback(signatureIndex);
+			return;
+		}
 
-		if( (signatureParts - 1) < lastPartIndex )
-			/* The signatures in this array doesn't have enough parts to
+		if( signature.getLastSetBit() >= (int)signatureSize )
+			/* The signatures in this array doesn't have enough bits to
 				be matched with the given query, so none will match */
 			return;
 
-
-		// The queried signature's data
-		unsigned char* signatureBits = signature.getBits();
-
-		// For each stored signature in array
-		for( unsigned int signatureIndex = 0; signatureIndex < numSignatures; signatureIndex++ ) {
-			bool match = true;
-
-			// For each part in the signature to check for match
-			for( unsigned int partIndex = firstPartIndex; partIndex < lastPartIndex + 1; partIndex++ ) {
-				unsigned matchingPart = data[signatureIndex * signatureParts + partIndex];
-
-				// Check if the bits set in the queried signature are also set in the matching
-				// parth, using the bitwise &.
-				// Note: It doesn't have to be an exact match; the matching part may container
-				// other set bits, but these are ignored
-				if( (matchingPart & signatureBits[partIndex]) != signatureBits[partIndex] ) {
-					match = false;
-					break;
+		// Columns of the queried bits (stored on the stack, unless the query has many bits)
+		unsigned char stackMemory[64 * sizeof(Column*)];
+		std::pmr::monotonic_buffer_resource stackResource(stackMemory, sizeof(stackMemory));
+		std::pmr::vector<const Column*> queryColumns(&stackResource);
+		queryColumns.reserve(signature.getBitsSet());
+		signature.forEachSetBit([this, &queryColumns](unsigned int bitIndex) {
+			queryColumns.push_back(&columns[bitIndex]);
+		});
+
+		unsigned int blockWords = (columnWords + 63) / 64;
+		for( unsigned int blockWordIndex = 0; blockWordIndex < blockWords; blockWordIndex++ ) {
+
+			// Blocks where all queried bits are set in some signature
+			uint64_t blocks = ~(uint64_t)0;
+			for( auto column : queryColumns )
+				blocks &= column->blocks[blockWordIndex];
+
+			while( blocks != 0 ) {
+				unsigned int wordIndex = blockWordIndex * 64 + BitOperations::countTrailingZeros(blocks);
+
+				// Signatures in the block with all queried bits set
+				uint64_t matches = ~(uint64_t)0;
+				for( auto column : queryColumns )
+					matches &= column->signatures[wordIndex];
+
+				while( matches != 0 ) {
+					callback(wordIndex * 64 + BitOperations::countTrailingZeros(matches));
+					matches &= matches - 1;
 				}
+				blocks &= blocks - 1;
 			}
-
-			if( match ) callback(signatureIndex);
 		}
 	}
 
@@ -77,9 +98,12 @@ namespace River::ECS {
 		if( !(signatureIndex < numSignatures) )
 			throw new IndexOutOfBoundsException(signatureIndex, numSignatures);
 
-		// TODO: Consider adding a bit out of bounds
+		if( !(bitIndex < signatureSize) )
+			throw std::out_of_range("Signature bit index out of range (i=" + std::to_string(bitIndex) + ", size=" + std::to_string(signatureSize) + ")");
 
-		bitManipulator.set(signatureIndex*signatureParts*8 + bitIndex);
+		if( layout == SignatureLayout::RowMajor )
+			data[signatureIndex * signatureParts + bitIndex / 8] |= (unsigned char)(1 << (bitIndex % 8));
+		setColumnBit(bitIndex, signatureIndex);
 	}
 
 
@@ -87,9 +111,12 @@ namespace River::ECS {
 		if( !(signatureIndex < numSignatures) )
 			throw new IndexOutOfBoundsException(signatureIndex, numSignatures);
 
-		// TODO: Consider adding a bit out of bounds
+		if( !(bitIndex < signatureSize) )
+			throw std::out_of_range("Signature bit index out of range (i=" + std::to_string(bitIndex) + ", size=" + std::to_string(signatureSize) + ")");
 
-		bitManipulator.unset(signatureIndex * signatureParts * 8 + bitIndex);
+		if( layout == SignatureLayout::RowMajor )
+			data[signatureIndex * signatureParts + bitIndex / 8] &= (unsigned char)~(1 << (bitIndex % 8));
+		unsetColumnBit(bitIndex, signatureIndex);
 	}
 
 
@@ -97,9 +124,34 @@ namespace River::ECS {
 		if( !(signatureIndex < numSignatures) )
 			throw new IndexOutOfBoundsException(signatureIndex, numSignatures);
 
-		// TODO: Consider adding a bit out of bounds
+		if( !(bitIndex < signatureSize) )
+			throw std::out_of_range("Signature bit index out of range (i=" + std::to_string(bitIndex) + ", size=" + std::to_string(signatureSize) + ")");
 
-		return bitManipulator.get(signatureIndex*signatureParts*8 + bitIndex);
+		return getColumnBit(bitIndex, signatureIndex);
+	}
+
+
+
+	void SignatureArray::forEachSetBit(unsigned int signatureIndex, std::function<void(unsigned int bitIndex)> callback) {
+		if( !(signatureIndex < numSignatures) )
+			throw new IndexOutOfBoundsException(signatureIndex, numSignatures);
+
+		if( layout == SignatureLayout::ColumnMajor ) {
+			for( unsigned int bitIndex = 0; bitIndex < signatureSize; bitIndex++ ) {
+				if( getColumnBit(bitIndex, signatureIndex) )
+					callback(bitIndex);
+			}
+			return;
+		}
+
+		unsigned int signature = signatureIndex * signatureParts;
+		for( unsigned int part = 0; part < signatureParts; part++ ) {
+			uint64_t bits = data[signature + part];
+			while( bits != 0 ) {
+				callback(part * 8 + BitOperations::countTrailingZeros(bits));
+				bits &= bits - 1;
+			}
+		}
 	}
 
 
@@ -110,50 +162,52 @@ namespace River::ECS {
 
 		if( newSignatureSize < signatureSize )
 			throw new SignatureSizeReducedException(signatureSize, newSignatureSize);
-		
-		// Check if more parts are required (i.e. we go from 8 to 9 in size)
-		unsigned int newSignatureParts = 1 + (newSignatureSize - 1) / 8;
-		unsigned int partsDifference = newSignatureParts - signatureParts;
 
-		if( partsDifference > 0 ) {
+		// Grow the capacity geometrically, so signatures are rarely moved
+		if( newSignatureSize > signatureParts * 8 )
+			reserveSignatureSize(std::max(newSignatureSize, signatureParts * 8 * 2));
 
-			// Extend memory with memory for new parts
-			reserveMemory(newSignatureParts * numSignatures + memoryStepSize);
+		signatureSize = newSignatureSize;
 
-			// Pointers to last part of last signature in version of the data
-			unsigned char* oldData = data + (signatureParts-1) + (numSignatures-1) * signatureParts;
-			unsigned char* newData = data + (newSignatureParts-1) + (numSignatures-1) * newSignatureParts;
+		// Add empty columns for the new bits
+		while( columns.size() < signatureSize ) {
+			columns.emplace_back(memoryResource);
+			columns.back().signatures.reserve(columnCapacity);
+			columns.back().blocks.reserve((columnCapacity + 63) / 64);
+			columns.back().signatures.resize(columnWords, 0);
+			columns.back().blocks.resize((columnWords + 63) / 64, 0);
+		}
+	}
 
-			// Create new empty parts in the each signatures new place place, and move old parts
-			// from signatures original place
-			for( int signatureIndex = numSignatures - 1; signatureIndex >= 0; signatureIndex-- ) {
-				int partIndex = newSignatureParts - 1;
 
-				// Add new empty parts
-				for( unsigned int i = 0; i < partsDifference; i++ ) {
-					*newData = 0;
-					newData--;
-					partIndex--;
-				}
+	void SignatureArray::reserveSignatureSize(unsigned int numBits) {
+		columns.reserve(numBits);
 
-				// Add old existing parts
-				for( unsigned int i = 0; i < signatureParts; i++ ) {
-					*newData = *oldData;
-					newData--;
-					oldData--;
-				}
-			}
+		unsigned int newSignatureParts = BitOperations::numWords((numBits + 7) / 8) * 8;
+		if( newSignatureParts <= signatureParts )
+			return;
 
-			signatureParts = newSignatureParts;
-		}
+		if( layout == SignatureLayout::RowMajor )
+			resizeRows(newSignatureParts);
+		signatureParts = newSignatureParts;
+	}
 
-		signatureSize = newSignatureSize;
-		bitManipulator.setData(data, numSignatures * signatureParts * 8);
+
+	unsigned int SignatureArray::getSignatureCapacity() {
+		return signatureParts * 8;
 	}
 
 
 
-	unsigned int SignatureArray::add() {
+	unsigned int SignatureArray::add(Entity* entity) {
+		entities.push_back(entity);
+
+		if( layout == SignatureLayout::ColumnMajor ) {
+			numSignatures++;
+			reserveColumns();
+			return numSignatures - 1;
+		}
+
 		reserveSignatures(++numSignatures);
 
 		// Initialize new signature to 0
@@ -161,7 +215,7 @@ namespace River::ECS {
 		for( unsigned int i = signatureIndex * signatureParts; i < numSignatures * signatureParts; i++ )
 			data[i] = 0;
 
-		bitManipulator.setData(data, numSignatures * signatureParts * 8);
+		reserveColumns();
 
 		return signatureIndex;
 	}
@@ -173,49 +227,290 @@ namespace River::ECS {
 			throw new IndexOutOfBoundsException(index, numSignatures);
 
 		numSignatures--;
-		if( numSignatures == 0 || numSignatures == index ) return 0;
-		
-		// Move last signature to removed signatures slot
-		unsigned char* lastSignature = data + (size_t)numSignatures * signatureParts;
-		unsigned char* deletedSignature = data + (size_t)index * signatureParts;
-		for( unsigned int part = 0; part < signatureParts; part++ )
-			deletedSignature[part] = lastSignature[part];
 
-		bitManipulator.setData(data, numSignatures * signatureParts*8);
+		entities[index] = entities[numSignatures];
+		entities.pop_back();
+
+		if( layout == SignatureLayout::ColumnMajor ) {
+			// Move the last signature's bit to the removed signature in each column
+			for( unsigned int bitIndex = 0; bitIndex < signatureSize; bitIndex++ ) {
+				bool lastBit = getColumnBit(bitIndex, numSignatures);
+				unsetColumnBit(bitIndex, numSignatures);
+				if( index == numSignatures ) continue;
+				if( lastBit )
+					setColumnBit(bitIndex, index);
+				else
+					unsetColumnBit(bitIndex, index);
+			}
+			shrinkIfUnused();
+
+			if( numSignatures == 0 || numSignatures == index ) return 0;
+			return numSignatures;
+		}
+
+		unsigned int lastSignature = numSignatures * signatureParts;
+		unsigned int deletedSignature = index * signatureParts;
+
+		// Move the last signature's column bits to the removed signature
+		for( unsigned int part = 0; part < signatureParts; part++ ) {
+			uint64_t deletedBits = data[deletedSignature + part];
+			while( deletedBits != 0 ) {
+				unsetColumnBit(part * 8 + BitOperations::countTrailingZeros(deletedBits), index);
+				deletedBits &= deletedBits - 1;
+			}
+
+			if( index == numSignatures ) continue;
+			uint64_t lastBits = data[lastSignature + part];
+			while( lastBits != 0 ) {
+				unsigned int bitIndex = part * 8 + BitOperations::countTrailingZeros(lastBits);
+				unsetColumnBit(bitIndex, numSignatures);
+				setColumnBit(bitIndex, index);
+				lastBits &= lastBits - 1;
+			}
+		}
+
+		// Move last signature to removed signatures slot (the last slot is cleared when a signature is added to it)
+		if( deletedSignature != lastSignature )
+			memcpy(data + deletedSignature, data + lastSignature, signatureParts);
+
+		shrinkIfUnused();
 
+		if( numSignatures == 0 || numSignatures == index ) return 0;
 		return numSignatures;
 	}
 
 	
 	void SignatureArray::reserveSignatures(unsigned int newNumSignatures) {
-		unsigned int newMemorySize = memorySize;
-		while( newMemorySize/signatureParts < newNumSignatures ) {
-			newMemorySize += memoryStepSize;
-		}
-		
-		if( newMemorySize > memorySize )
-			reserveMemory(newNumSignatures * signatureParts);
+		reserveColumnCapacity((newNumSignatures + 63) / 64);
+		if( layout == SignatureLayout::ColumnMajor )
+			return;
+
+		// Grow geometrically, so adding signatures one at a time has amortized constant cost
+		unsigned int requiredMemory = newNumSignatures * signatureParts;
+		if( requiredMemory > memorySize )
+			reserveMemory(std::max({ requiredMemory, memorySize * 2, memoryStepSize }));
 	}
 
 
 	void SignatureArray::reserveMemory(unsigned int bytes) {
 		if( bytes <= memorySize ) return;
+		reallocate(bytes);
+		numGrowths++;
+	}
+
+
+	void SignatureArray::shrinkToFit() {
+		trimColumns();
+		entities.shrink_to_fit();
+		bool shrunk = false;
 
-		auto newData = (unsigned char*) realloc(data, sizeof(unsigned char) * bytes);
-		if( newData == nullptr )
-			throw MemoryAllocationException(bytes);
+		unsigned int requiredMemory = numSignatures * signatureParts;
+		if( layout == SignatureLayout::RowMajor && requiredMemory < memorySize ) {
+			reallocate(requiredMemory);
+			shrunk = true;
+		}
+
+		if( columnWords < columnCapacity ) {
+			resizeColumnCapacity(columnWords);
+			shrunk = true;
+		}
+
+		if( shrunk ) numShrinks++;
+	}
+
+
+	unsigned int SignatureArray::getNumGrowths() {
+		return numGrowths;
+	}
+
+
+	unsigned int SignatureArray::getNumShrinks() {
+		return numShrinks;
+	}
+
+
+	void SignatureArray::shrinkIfUnused() {
+		// Shrinks to twice the used memory, so signatures can be added again without growing right away
+		trimColumns();
+		bool shrunk = false;
+
+		unsigned int requiredMemory = numSignatures * signatureParts;
+		if( layout == SignatureLayout::RowMajor && memorySize > memoryStepSize && requiredMemory < memorySize / 4 ) {
+			reallocate(std::max(requiredMemory * 2, memoryStepSize));
+			shrunk = true;
+		}
+
+		if( columnCapacity > 1 && columnWords < columnCapacity / 4 ) {
+			resizeColumnCapacity(std::max(columnWords * 2, 1u));
+			shrunk = true;
+		}
+
+		if( shrunk ) numShrinks++;
+	}
+
+
+	void SignatureArray::reallocate(unsigned int bytes) {
+		unsigned char* newData = nullptr;
+		if( bytes > 0 ) {
+			try {
+				newData = (unsigned char*) memoryResource->allocate(sizeof(unsigned char) * bytes, alignof(uint64_t));
+			} catch( const std::bad_alloc& ) {
+				throw MemoryAllocationException(bytes);
+			}
+		}
+
+		// Only the memory of existing signatures is copied
+		if( data != nullptr ) {
+			if( newData != nullptr )
+				memcpy(newData, data, std::min({ (size_t)memorySize, (size_t)bytes, (size_t)numSignatures * signatureParts }));
+			memoryResource->deallocate(data, memorySize, alignof(uint64_t));
+		}
 		
 		data = newData;
 		memorySize = bytes;
+	}
+
+
+	void SignatureArray::copyFrom(const SignatureArray& other) {
+		layout = other.layout;
+		numSignatures = other.numSignatures;
+		signatureSize = other.signatureSize;
+		signatureParts = other.signatureParts;
+		entities = other.entities;
+
+		if( layout == SignatureLayout::RowMajor ) {
+			reserveMemory(numSignatures * signatureParts);
+			if( numSignatures > 0 )
+				memcpy(data, other.data, (size_t)numSignatures * signatureParts);
+		}
+
+		// The columns keep (at least) the other array's capacity, so adding signatures doesn't reallocate right away
+		columnCapacity = std::max(columnCapacity, other.columnCapacity);
+		while( columns.size() < other.columns.size() )
+			columns.emplace_back(memoryResource);
+		columns.erase(columns.begin() + other.columns.size(), columns.end());
+		for( size_t i = 0; i < columns.size(); i++ ) {
+			columns[i].signatures.reserve(columnCapacity);
+			columns[i].blocks.reserve((columnCapacity + 63) / 64);
+			columns[i].signatures.assign(other.columns[i].signatures.begin(), other.columns[i].signatures.end());
+			columns[i].blocks.assign(other.columns[i].blocks.begin(), other.columns[i].blocks.end());
+		}
+		columnWords = other.columnWords;
+	}
 
-		bitManipulator.setData(data, numSignatures*signatureParts*8);
+
+	void SignatureArray::setColumnBit(unsigned int bitIndex, unsigned int signatureIndex) {
+		Column& column = columns[bitIndex];
+		unsigned int wordIndex = signatureIndex / 64;
+		column.signatures[wordIndex] |= (uint64_t)1 << (signatureIndex % 64);
+		column.blocks[wordIndex / 64] |= (uint64_t)1 << (wordIndex % 64);
+	}
+
+
+	void SignatureArray::unsetColumnBit(unsigned int bitIndex, unsigned int signatureIndex) {
+		Column& column = columns[bitIndex];
+		unsigned int wordIndex = signatureIndex / 64;
+		column.signatures[wordIndex] &= ~((uint64_t)1 << (signatureIndex % 64));
+		if( column.signatures[wordIndex] == 0 )
+			column.blocks[wordIndex / 64] &= ~((uint64_t)1 << (wordIndex % 64));
 	}
 
 
-	unsigned int SignatureArray::getNumSignatures() {
+	bool SignatureArray::getColumnBit(unsigned int bitIndex, unsigned int signatureIndex) const {
+		return (columns[bitIndex].signatures[signatureIndex / 64] >> (signatureIndex % 64)) & 1;
+	}
+
+
+	void SignatureArray::resizeRows(unsigned int newSignatureParts) {
+		reserveMemory(newSignatureParts * numSignatures + memoryStepSize);
+
+		// Move signatures from the last, so no signature is overwritten before it's moved, and clear the new parts
+		for( int signatureIndex = (int)numSignatures - 1; signatureIndex >= 0; signatureIndex-- ) {
+			unsigned char* oldSignature = data + (size_t)signatureIndex * signatureParts;
+			unsigned char* newSignature = data + (size_t)signatureIndex * newSignatureParts;
+			memmove(newSignature, oldSignature, signatureParts);
+			memset(newSignature + signatureParts, 0, newSignatureParts - signatureParts);
+		}
+	}
+
+
+	void SignatureArray::reserveColumns() {
+		unsigned int requiredWords = (numSignatures + 63) / 64;
+		if( requiredWords <= columnWords ) return;
+
+		reserveColumnCapacity(requiredWords);
+		for( auto& column : columns ) {
+			column.signatures.resize(requiredWords, 0);
+			column.blocks.resize((requiredWords + 63) / 64, 0);
+		}
+		columnWords = requiredWords;
+	}
+
+
+	void SignatureArray::trimColumns() {
+		// Words past the last signature are always 0, so they can be dropped
+		unsigned int requiredWords = (numSignatures + 63) / 64;
+		if( requiredWords >= columnWords ) return;
+
+		for( auto& column : columns ) {
+			column.signatures.resize(requiredWords);
+			column.blocks.resize((requiredWords + 63) / 64);
+		}
+		columnWords = requiredWords;
+	}
+
+
+	void SignatureArray::reserveColumnCapacity(unsigned int words) {
+		if( words <= columnCapacity ) return;
+		resizeColumnCapacity(std::max(words, columnCapacity * 2));
+		numGrowths++;
+	}
+
+
+	void SignatureArray::resizeColumnCapacity(unsigned int words) {
+		// Columns are copied to new vectors, as vectors don't shrink their memory on request
+		for( auto& column : columns ) {
+			std::pmr::vector<uint64_t> signatures(memoryResource);
+			signatures.reserve(words);
+			signatures.assign(column.signatures.begin(), column.signatures.end());
+			column.signatures.swap(signatures);
+
+			std::pmr::vector<uint64_t> blocks(memoryResource);
+			blocks.reserve((words + 63) / 64);
+			blocks.assign(column.blocks.begin(), column.blocks.end());
+			column.blocks.swap(blocks);
+		}
+		columnCapacity = words;
+	}
+
+
+	unsigned int SignatureArray::getNumSignatures() const {
 		return numSignatures;
 	}
 
+	MemoryUsage SignatureArray::getRowMemoryUsage() const {
+		if( layout == SignatureLayout::ColumnMajor )
+			return {};
+		return { (size_t)numSignatures * signatureParts, memorySize };
+	}
+
+
+	MemoryUsage SignatureArray::getColumnMemoryUsage() const {
+		MemoryUsage usage;
+		usage.reservedBytes = columns.capacity() * sizeof(Column);
+		for( auto& column : columns ) {
+			usage += getVectorMemoryUsage(column.signatures);
+			usage += getVectorMemoryUsage(column.blocks);
+		}
+		return usage;
+	}
+
+
+	MemoryUsage SignatureArray::getEntityMemoryUsage() const {
+		return getVectorMemoryUsage(entities);
+	}
+
+
 	unsigned int SignatureArray::getMemorySize() {
 		return memorySize;
 	}
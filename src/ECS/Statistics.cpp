@@ -0,0 +1,119 @@
+#include "Statistics.h"
+
+#include <sstream>
+#include <numeric>
+
+#include "Json.h"
+
+
+namespace River::ECS {
+
+	void ComponentTypeStatistics::recordArrayLayout(const void* data, size_t elementSize, size_t count) {
+		componentSize += (unsigned int)elementSize;
+		if( count == 0 || elementSize == 0 ) return;
+
+		uintptr_t start = reinterpret_cast<uintptr_t>(data);
+		cacheLines += (start + count * elementSize - 1) / CACHE_LINE_SIZE - start / CACHE_LINE_SIZE + 1;
+
+		// The elements' offsets within their cache line repeat with this period, so only one period is checked
+		size_t minLines = (elementSize + CACHE_LINE_SIZE - 1) / CACHE_LINE_SIZE;
+		size_t period = CACHE_LINE_SIZE / std::gcd(elementSize, CACHE_LINE_SIZE);
+		size_t straddlingPerPeriod = 0;
+		size_t straddlingInRemainder = 0;
+		for( size_t i = 0; i < period && i < count; i++ ) {
+			size_t offset = (start + i * elementSize) % CACHE_LINE_SIZE;
+			if( (offset + elementSize - 1) / CACHE_LINE_SIZE + 1 > minLines ) {
+				straddlingPerPeriod++;
+				if( i < count % period ) straddlingInRemainder++;
+			}
+		}
+		straddlingComponents += (unsigned int)((count / period) * straddlingPerPeriod + straddlingInRemainder);
+	}
+
+
+	double ComponentTypeStatistics::getCacheLineUtilization() const {
+		if( cacheLines == 0 ) return 1;
+		return (double)numComponents * componentSize / (double)(cacheLines * CACHE_LINE_SIZE);
+	}
+
+
+	void DomainStatistics::reset() {
+		entitiesCreated = 0;
+		entitiesDestroyed = 0;
+		cleanNanoseconds = 0;
+		createEntitiesNanoseconds = 0;
+		addComponentsNanoseconds = 0;
+		removeComponentsNanoseconds = 0;
+		destroyEntitiesNanoseconds = 0;
+		cleanControllersNanoseconds = 0;
+
+		// Controllers point to their component type's statistics, so these aren't removed
+		for( auto& pair : componentTypes ) {
+			std::string name = std::move(pair.second.name);
+			pair.second = ComponentTypeStatistics();
+			pair.second.name = std::move(name);
+		}
+
+		queries.clear();
+	}
+
+
+	std::string DomainStatistics::toJson() const {
+		std::ostringstream stream;
+		stream << "{";
+		stream << "\"entitiesCreated\":" << entitiesCreated;
+		stream << ",\"entitiesDestroyed\":" << entitiesDestroyed;
+		stream << ",\"cleanNanoseconds\":" << cleanNanoseconds;
+		stream << ",\"createEntitiesNanoseconds\":" << createEntitiesNanoseconds;
+		stream << ",\"addComponentsNanoseconds\":" << addComponentsNanoseconds;
+		stream << ",\"removeComponentsNanoseconds\":" << removeComponentsNanoseconds;
+		stream << ",\"destroyEntitiesNanoseconds\":" << destroyEntitiesNanoseconds;
+		stream << ",\"cleanControllersNanoseconds\":" << cleanControllersNanoseconds;
+
+		// Component types are written in order of their id, so the output is stable
+		std::map<ComponentTypeId, const ComponentTypeStatistics*> sortedComponentTypes;
+		for( auto& pair : componentTypes )
+			sortedComponentTypes.emplace(pair.first, &pair.second);
+
+		stream << ",\"componentTypes\":[";
+		bool first = true;
+		for( auto& pair : sortedComponentTypes ) {
+			if( !first ) stream << ",";
+			first = false;
+			stream << "{\"id\":" << pair.first << ",\"name\":";
+			writeJsonString(stream, pair.second->name);
+			stream << ",\"added\":" << pair.second->added;
+			stream << ",\"removed\":" << pair.second->removed;
+			stream << ",\"moved\":" << pair.second->moved;
+			stream << ",\"swapped\":" << pair.second->swapped;
+			stream << ",\"moveNanoseconds\":" << pair.second->moveNanoseconds;
+			stream << ",\"deleteNanoseconds\":" << pair.second->deleteNanoseconds;
+			stream << ",\"numComponents\":" << pair.second->numComponents;
+			stream << ",\"componentSize\":" << pair.second->componentSize;
+			stream << ",\"cacheLines\":" << pair.second->cacheLines;
+			stream << ",\"straddlingComponents\":" << pair.second->straddlingComponents;
+			stream << ",\"cacheLineUtilization\":" << pair.second->getCacheLineUtilization();
+			stream << "}";
+		}
+		stream << "]";
+
+		stream << ",\"queries\":[";
+		first = true;
+		for( auto& pair : queries ) {
+			if( !first ) stream << ",";
+			first = false;
+			stream << "{\"componentTypes\":[";
+			for( size_t i = 0; i < pair.first.size(); i++ )
+				stream << (i > 0 ? "," : "") << pair.first[i];
+			stream << "],\"numQueries\":" << pair.second.numQueries;
+			stream << ",\"numMatches\":" << pair.second.numMatches;
+			stream << ",\"nanoseconds\":" << pair.second.nanoseconds;
+			stream << "}";
+		}
+		stream << "]";
+
+		stream << "}";
+		return stream.str();
+	}
+
+}
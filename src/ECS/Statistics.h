@@ -0,0 +1,175 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <map>
+#include <unordered_map>
+#include <chrono>
+
+#include "Component.h"
+
+
+/*	Statistics are only collected if RV_ECS_ENABLE_STATISTICS is defined (for both the library and the
+	code using it). Otherwise the macros below compile to nothing, and all statistics stay 0. */
+#ifdef RV_ECS_ENABLE_STATISTICS
+#define RV_ECS_STATISTICS(...) __VA_ARGS__
+#define RV_ECS_STATISTICS_TIMER(nanoseconds) River::ECS::StatisticsTimer RV_ECS_STATISTICS_CONCAT(statisticsTimer, __LINE__)(nanoseconds)
+#else
+#define RV_ECS_STATISTICS(...)
+#define RV_ECS_STATISTICS_TIMER(nanoseconds)
+#endif
+
+#define RV_ECS_STATISTICS_CONCAT_INNER(a, b) a##b
+#define RV_ECS_STATISTICS_CONCAT(a, b) RV_ECS_STATISTICS_CONCAT_INNER(a, b)
+
+
+namespace River::ECS {
+
+	/**
+	 * @brief The cache line size in bytes, which the cache line statistics are computed with */
+	const size_t CACHE_LINE_SIZE = 64;
+
+
+	/**
+	 * @brief	Adds the time from its construction to its destruction to the given number of nanoseconds (if not null)
+	*/
+	class StatisticsTimer {
+		using Clock = std::chrono::steady_clock;
+	public:
+		StatisticsTimer(uint64_t* nanoseconds = nullptr) : nanoseconds(nanoseconds), start(Clock::now()), lapStart(start) {}
+
+		~StatisticsTimer() {
+			if( nanoseconds != nullptr )
+				*nanoseconds += getElapsed();
+		}
+
+		/**
+		 * @return	Nanoseconds since the timer was constructed
+		*/
+		uint64_t getElapsed() const {
+			return toNanoseconds(Clock::now() - start);
+		}
+
+		/**
+		 * @brief	Adds the time since the last lap (or the construction) to the given nanoseconds, and starts a new lap
+		*/
+		void lap(uint64_t& lapNanoseconds) {
+			auto now = Clock::now();
+			lapNanoseconds += toNanoseconds(now - lapStart);
+			lapStart = now;
+		}
+
+	private:
+		static uint64_t toNanoseconds(Clock::duration duration) {
+			return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(duration).count();
+		}
+
+	private:
+		uint64_t* nanoseconds;
+		Clock::time_point start;
+		Clock::time_point lapStart;
+	};
+
+
+	/**
+	 * @brief	Statistics for a single component type
+	*/
+	struct ComponentTypeStatistics {
+		std::string name;
+
+		unsigned int added = 0;
+		unsigned int removed = 0;
+
+		/**
+		 * @brief Number of new components copied into the primary list by moveNewComponents() */
+		unsigned int moved = 0;
+
+		/**
+		 * @brief Number of components moved into the slot of a deleted component by deleteComponents() */
+		unsigned int swapped = 0;
+
+		uint64_t moveNanoseconds = 0;
+		uint64_t deleteNanoseconds = 0;
+
+		/**
+		 * @brief Number of cleaned components at the end of the frame */
+		unsigned int numComponents = 0;
+
+		/**
+		 * @brief Bytes stored per component (the size of the component, or the sum of the sizes of its stored fields
+		 *			if it's stored as a structure of arrays) */
+		unsigned int componentSize = 0;
+
+		/**
+		 * @brief Number of cache lines which the cleaned components occupy */
+		uint64_t cacheLines = 0;
+
+		/**
+		 * @brief Number of components (or fields) which occupy more cache lines than their size requires */
+		unsigned int straddlingComponents = 0;
+
+
+		/**
+		 * @brief	Adds the layout of an array of the component type's storage to the cache line statistics
+		 * @param elementSize	Size of each element in bytes
+		 * @param count	Number of elements in use
+		*/
+		void recordArrayLayout(const void* data, size_t elementSize, size_t count);
+
+		/**
+		 * @return	Fraction of the bytes of the occupied cache lines which are component data (1 if there are none)
+		*/
+		double getCacheLineUtilization() const;
+	};
+
+
+	/**
+	 * @brief	Statistics for queries of a single combination of component types
+	*/
+	struct QueryStatistics {
+		unsigned int numQueries = 0;
+
+		/**
+		 * @brief Total number of entities matched by the queries */
+		unsigned int numMatches = 0;
+
+		/**
+		 * @brief Total time of the queries (including the time spent in the callbacks) */
+		uint64_t nanoseconds = 0;
+	};
+
+
+	/**
+	 * @brief	Statistics for a single frame of a Domain (from the end of one clean, to the end of the next)
+	*/
+	struct DomainStatistics {
+		unsigned int entitiesCreated = 0;
+		unsigned int entitiesDestroyed = 0;
+
+		uint64_t cleanNanoseconds = 0;
+		uint64_t createEntitiesNanoseconds = 0;
+		uint64_t addComponentsNanoseconds = 0;
+		uint64_t removeComponentsNanoseconds = 0;
+		uint64_t destroyEntitiesNanoseconds = 0;
+		uint64_t cleanControllersNanoseconds = 0;
+
+		std::unordered_map<ComponentTypeId, ComponentTypeStatistics> componentTypes;
+
+		/**
+		 * @brief Maps the queried component types to their statistics */
+		std::map<std::vector<ComponentTypeId>, QueryStatistics> queries;
+
+
+		/**
+		 * @brief	Sets all counts and timings to 0. Component types are kept (with their names).
+		*/
+		void reset();
+
+		/**
+		 * @return	The statistics as a JSON object
+		*/
+		std::string toJson() const;
+	};
+
+}
@@ -0,0 +1,294 @@
+#include "Tracing.h"
+
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <memory>
+#include <vector>
+#include <map>
+#include <string>
+#include <iomanip>
+#include <algorithm>
+
+#include "Json.h"
+#include "ByteWriter.h"
+
+
+namespace River::ECS {
+
+	/**
+	 * @brief	Ring buffer of a single thread's events. Only the owning thread writes to it.
+	*/
+	struct TraceBuffer {
+		TraceBuffer(unsigned int threadIndex) : threadIndex(threadIndex), events(Tracing::BUFFER_CAPACITY) {}
+
+		unsigned int threadIndex;
+		std::vector<TraceEvent> events;
+
+		/**
+		 * @brief Total number of events recorded (the newest event is at (numRecorded-1) % capacity) */
+		std::atomic<uint64_t> numRecorded = 0;
+
+		/**
+		 * @brief Value of numRecorded when the buffer was last cleared */
+		uint64_t numCleared = 0;
+
+		/**
+		 * @brief Whether a running thread owns the buffer (buffers of finished threads are reused) */
+		bool inUse = true;
+	};
+
+
+	/**
+	 * @brief	Buffers of all threads which have recorded events. Buffers are never deleted (before exit),
+	 *			so their events can be read after the thread has finished.
+	*/
+	struct TraceBuffers {
+		std::mutex mutex;
+		std::vector<std::unique_ptr<TraceBuffer>> buffers;
+	};
+
+	static TraceBuffers& getTraceBuffers() {
+		static TraceBuffers buffers;
+		return buffers;
+	}
+
+
+	/**
+	 * @brief	Releases the thread's buffer when the thread finishes
+	*/
+	struct ThreadTraceBuffer {
+		TraceBuffer* buffer = nullptr;
+
+		~ThreadTraceBuffer() {
+			if( buffer == nullptr ) return;
+			std::lock_guard<std::mutex> lock(getTraceBuffers().mutex);
+			buffer->inUse = false;
+		}
+	};
+
+	static TraceBuffer* getThreadTraceBuffer() {
+		thread_local ThreadTraceBuffer threadBuffer;
+		if( threadBuffer.buffer != nullptr )
+			return threadBuffer.buffer;
+
+		auto& traceBuffers = getTraceBuffers();
+		std::lock_guard<std::mutex> lock(traceBuffers.mutex);
+		for( auto& buffer : traceBuffers.buffers ) {
+			if( !buffer->inUse ) {
+				buffer->inUse = true;
+				threadBuffer.buffer = buffer.get();
+				return threadBuffer.buffer;
+			}
+		}
+
+		traceBuffers.buffers.emplace_back(new TraceBuffer((unsigned int)traceBuffers.buffers.size()));
+		threadBuffer.buffer = traceBuffers.buffers.back().get();
+		return threadBuffer.buffer;
+	}
+
+
+	uint64_t Tracing::now() {
+		static const auto epoch = std::chrono::steady_clock::now();
+		return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - epoch).count();
+	}
+
+
+	void Tracing::record(const char* name, const char* detail, uint64_t start, uint64_t end) {
+		auto buffer = getThreadTraceBuffer();
+		auto index = buffer->numRecorded.load(std::memory_order_relaxed);
+		buffer->events[index % BUFFER_CAPACITY] = { name, detail, start, end - start };
+		buffer->numRecorded.store(index + 1, std::memory_order_release);
+	}
+
+
+	void Tracing::forEachEvent(std::function<void(unsigned int threadIndex, const TraceEvent&)> callback) {
+		auto& traceBuffers = getTraceBuffers();
+		std::lock_guard<std::mutex> lock(traceBuffers.mutex);
+		for( auto& buffer : traceBuffers.buffers ) {
+			auto numRecorded = buffer->numRecorded.load(std::memory_order_acquire);
+			auto first = std::max(buffer->numCleared, numRecorded > BUFFER_CAPACITY ? numRecorded - BUFFER_CAPACITY : 0);
+			for( auto i = first; i < numRecorded; i++ )
+				callback(buffer->threadIndex, buffer->events[i % BUFFER_CAPACITY]);
+		}
+	}
+
+
+	void Tracing::clear() {
+		auto& traceBuffers = getTraceBuffers();
+		std::lock_guard<std::mutex> lock(traceBuffers.mutex);
+		for( auto& buffer : traceBuffers.buffers )
+			buffer->numCleared = buffer->numRecorded.load(std::memory_order_acquire);
+	}
+
+
+	/**
+	 * @brief	Writes the nanoseconds as microseconds with 3 decimals (the unit of Chrome trace timestamps)
+	*/
+	static void writeMicroseconds(std::ostream& stream, uint64_t nanoseconds) {
+		stream << nanoseconds / 1000 << '.' << std::setw(3) << std::setfill('0') << nanoseconds % 1000;
+	}
+
+
+	void Tracing::writeChromeTrace(std::ostream& stream) {
+		stream << "{\"traceEvents\":[";
+		bool first = true;
+		forEachEvent([&stream, &first](unsigned int threadIndex, const TraceEvent& event) {
+			if( !first ) stream << ",";
+			first = false;
+			stream << "{\"name\":";
+			writeJsonString(stream, event.name);
+			stream << ",\"cat\":\"ecs\",\"ph\":\"X\",\"pid\":1,\"tid\":" << threadIndex + 1 << ",\"ts\":";
+			writeMicroseconds(stream, event.start);
+			stream << ",\"dur\":";
+			writeMicroseconds(stream, event.duration);
+			if( event.detail != nullptr ) {
+				stream << ",\"args\":{\"detail\":";
+				writeJsonString(stream, event.detail);
+				stream << "}";
+			}
+			stream << "}";
+		});
+		stream << "],\"displayTimeUnit\":\"ns\"}";
+	}
+
+
+
+	/*	Field numbers of the Perfetto protobuf messages (see perfetto/protos/perfetto/trace/) which are written.
+		Each TracePacket is written as a 'packet' field of the top level Trace message. */
+	namespace PerfettoFields {
+		const unsigned int TRACE_PACKET = 1;
+
+		const unsigned int PACKET_TIMESTAMP = 8;
+		const unsigned int PACKET_SEQUENCE_ID = 10;
+		const unsigned int PACKET_TRACK_EVENT = 11;
+		const unsigned int PACKET_SEQUENCE_FLAGS = 13;
+		const unsigned int PACKET_TRACK_DESCRIPTOR = 60;
+
+		const unsigned int TRACK_DESCRIPTOR_UUID = 1;
+		const unsigned int TRACK_DESCRIPTOR_THREAD = 4;
+
+		const unsigned int THREAD_DESCRIPTOR_PID = 1;
+		const unsigned int THREAD_DESCRIPTOR_TID = 2;
+		const unsigned int THREAD_DESCRIPTOR_NAME = 5;
+
+		const unsigned int TRACK_EVENT_TYPE = 9;
+		const unsigned int TRACK_EVENT_TRACK_UUID = 11;
+		const unsigned int TRACK_EVENT_NAME = 23;
+
+		const uint64_t TYPE_SLICE_BEGIN = 1;
+		const uint64_t TYPE_SLICE_END = 2;
+		const uint64_t SEQUENCE_INCREMENTAL_STATE_CLEARED = 1;
+	}
+
+
+	/**
+	 * @brief	Writes protobuf fields (varints and length-delimited fields) to a byte buffer
+	*/
+	class ProtobufWriter {
+	public:
+
+		ProtobufWriter() {}
+		ProtobufWriter(const ProtobufWriter&) = delete;
+		ProtobufWriter& operator=(const ProtobufWriter&) = delete;
+
+		void writeVarInt(unsigned int field, uint64_t value) {
+			writer.writeVarUInt((uint64_t)field << 3 | 0);
+			writer.writeVarUInt(value);
+		}
+
+		void writeBytes(unsigned int field, const unsigned char* bytes, size_t numBytes) {
+			writer.writeVarUInt((uint64_t)field << 3 | 2);
+			writer.writeVarUInt(numBytes);
+			writer.writeBytes(bytes, numBytes);
+		}
+
+		void writeString(unsigned int field, const std::string& string) {
+			writeBytes(field, (const unsigned char*)string.data(), string.size());
+		}
+
+		void writeMessage(unsigned int field, const ProtobufWriter& message) {
+			writeBytes(field, message.buffer.data(), message.buffer.size());
+		}
+
+		const std::vector<unsigned char>& getBuffer() const {
+			return buffer;
+		}
+
+	private:
+		std::vector<unsigned char> buffer;
+		ByteWriter writer = ByteWriter(buffer);
+	};
+
+
+	void Tracing::writePerfettoTrace(std::ostream& stream) {
+		using namespace PerfettoFields;
+
+		std::map<unsigned int, std::vector<TraceEvent>> threadEvents;
+		forEachEvent([&threadEvents](unsigned int threadIndex, const TraceEvent& event) {
+			threadEvents[threadIndex].push_back(event);
+		});
+
+		ProtobufWriter trace;
+		for( auto& pair : threadEvents ) {
+			// Each thread is its own track and packet sequence
+			uint64_t uuid = pair.first + 1;
+
+			ProtobufWriter thread;
+			thread.writeVarInt(THREAD_DESCRIPTOR_PID, 1);
+			thread.writeVarInt(THREAD_DESCRIPTOR_TID, uuid);
+			thread.writeString(THREAD_DESCRIPTOR_NAME, "Thread " + std::to_string(pair.first));
+
+			ProtobufWriter track;
+			track.writeVarInt(TRACK_DESCRIPTOR_UUID, uuid);
+			track.writeMessage(TRACK_DESCRIPTOR_THREAD, thread);
+
+			ProtobufWriter descriptorPacket;
+			descriptorPacket.writeVarInt(PACKET_SEQUENCE_ID, uuid);
+			descriptorPacket.writeVarInt(PACKET_SEQUENCE_FLAGS, SEQUENCE_INCREMENTAL_STATE_CLEARED);
+			descriptorPacket.writeMessage(PACKET_TRACK_DESCRIPTOR, track);
+			trace.writeMessage(TRACE_PACKET, descriptorPacket);
+
+			auto writeSliceEvent = [&trace, uuid](uint64_t timestamp, uint64_t type, const TraceEvent* event) {
+				ProtobufWriter trackEvent;
+				trackEvent.writeVarInt(TRACK_EVENT_TYPE, type);
+				trackEvent.writeVarInt(TRACK_EVENT_TRACK_UUID, uuid);
+				if( event != nullptr ) {
+					std::string name = event->name;
+					if( event->detail != nullptr )
+						name = name + " (" + event->detail + ")";
+					trackEvent.writeString(TRACK_EVENT_NAME, name);
+				}
+
+				ProtobufWriter packet;
+				packet.writeVarInt(PACKET_TIMESTAMP, timestamp);
+				packet.writeVarInt(PACKET_SEQUENCE_ID, uuid);
+				packet.writeMessage(PACKET_TRACK_EVENT, trackEvent);
+				trace.writeMessage(TRACE_PACKET, packet);
+			};
+
+			// Events are recorded when they end, so they are sorted into begin/end pairs (outer events first)
+			auto& events = pair.second;
+			std::stable_sort(events.begin(), events.end(), [](const TraceEvent& a, const TraceEvent& b) {
+				return a.start != b.start ? a.start < b.start : a.duration > b.duration;
+			});
+
+			std::vector<uint64_t> openSliceEnds;
+			for( auto& event : events ) {
+				while( !openSliceEnds.empty() && openSliceEnds.back() <= event.start ) {
+					writeSliceEvent(openSliceEnds.back(), TYPE_SLICE_END, nullptr);
+					openSliceEnds.pop_back();
+				}
+				writeSliceEvent(event.start, TYPE_SLICE_BEGIN, &event);
+				openSliceEnds.push_back(event.start + event.duration);
+			}
+			while( !openSliceEnds.empty() ) {
+				writeSliceEvent(openSliceEnds.back(), TYPE_SLICE_END, nullptr);
+				openSliceEnds.pop_back();
+			}
+		}
+
+		stream.write((const char*)trace.getBuffer().data(), trace.getBuffer().size());
+	}
+
+}
@@ -0,0 +1,218 @@
+#pragma once
+
+#include <vector>
+#include <tuple>
+#include <iterator>
+#include <utility>
+#include <cstddef>
+#include <cstdint>
+#include <memory_resource>
+
+#include "ComponentFields.h"
+
+
+namespace River::ECS {
+	struct Entity;
+
+
+	/**
+	 * @brief	Range of the entities which matched a query (see Domain::view()), yielding an
+	 *			(Entity*, C&...) tuple per entity, which can be used with structured bindings:
+	 *
+	 *			for( auto [entity, a, b] : domain.view<A, B>() ) { ... }
+	 *
+	 * @details	The matches are stored when the view is created, and the view is valid until the Domain is cleaned.
+	 *			Entities and components created after the view was created aren't in the view. The views created
+	 *			by a Domain store their matches in its frame arena, so they must not outlive the Domain.
+	 * @tparam	C	The component types of the query
+	*/
+	template <typename ... C>
+	class View {
+		static_assert((!ComponentFields<C>::IS_SOA && ...), "Views can't be created of component types stored as structures of arrays (use ComponentRef::getField())");
+		static const size_t NUM_COMPONENT_TYPES = sizeof...(C);
+		static constexpr size_t COMPONENT_SIZES[] = { sizeof(C)... };
+
+	public:
+		using value_type = std::tuple<Entity*, C&...>;
+
+
+		/**
+		 * @brief	Random-access iterator over the view's matches. Dereferencing it creates the tuple of the match,
+		 *			so it yields values instead of references (the tuple holds references to the components).
+		*/
+		class Iterator {
+		public:
+			using iterator_category = std::random_access_iterator_tag;
+			using value_type = View::value_type;
+			using difference_type = std::ptrdiff_t;
+			using pointer = void;
+			using reference = value_type;
+
+			Iterator() = default;
+
+			value_type operator*() const { return (*view)[index]; }
+			value_type operator[](difference_type offset) const { return (*view)[index + offset]; }
+
+			Iterator& operator++() { index++; return *this; }
+			Iterator operator++(int) { Iterator copy = *this; index++; return copy; }
+			Iterator& operator--() { index--; return *this; }
+			Iterator operator--(int) { Iterator copy = *this; index--; return copy; }
+
+			Iterator& operator+=(difference_type offset) { index += offset; return *this; }
+			Iterator& operator-=(difference_type offset) { index -= offset; return *this; }
+			Iterator operator+(difference_type offset) const { return Iterator(view, index + offset); }
+			Iterator operator-(difference_type offset) const { return Iterator(view, index - offset); }
+			friend Iterator operator+(difference_type offset, const Iterator& iterator) { return iterator + offset; }
+			difference_type operator-(const Iterator& other) const { return (difference_type)index - (difference_type)other.index; }
+
+			bool operator==(const Iterator& other) const { return index == other.index; }
+			bool operator!=(const Iterator& other) const { return index != other.index; }
+			bool operator<(const Iterator& other) const { return index < other.index; }
+			bool operator>(const Iterator& other) const { return index > other.index; }
+			bool operator<=(const Iterator& other) const { return index <= other.index; }
+			bool operator>=(const Iterator& other) const { return index >= other.index; }
+
+		private:
+			Iterator(const View* view, size_t index) : view(view), index(index) {}
+
+		private:
+			const View* view = nullptr;
+			size_t index = 0;
+
+			friend class View;
+		};
+
+
+		View(std::pmr::memory_resource* memoryResource = std::pmr::get_default_resource()) :
+			entities(memoryResource),
+			components(memoryResource)
+		{}
+
+
+		Iterator begin() const {
+			return Iterator(this, 0);
+		}
+
+
+		Iterator end() const {
+			return Iterator(this, entities.size());
+		}
+
+
+		/**
+		 * @return	The match at the index
+		*/
+		value_type operator[](size_t index) const {
+			return getMatch(index, std::index_sequence_for<C...>());
+		}
+
+
+		/**
+		 * @return	Number of matching entities
+		*/
+		size_t size() const {
+			return entities.size();
+		}
+
+
+		bool empty() const {
+			return entities.empty();
+		}
+
+
+		/**
+		 * @brief	Calls the callback for each chunk of the view: a run of matches whose components are contiguous
+		 *			in memory for each of the component types, so they can be processed as raw arrays (i.e. by SIMD kernels).
+		 *			The callback is called as callback(Entity* const* entities, size_t count, C* ... components).
+		 *
+		 * @details	How long the runs are depends on the order of the components in the Domain's storage.
+		 * @param alignment	If not 0, a run is split at its first match where the components of all types are aligned to
+		 *					this number of bytes, so the rest of the run is one aligned chunk
+		*/
+		template <typename Func>
+		void forEachChunk(Func callback, size_t alignment = 0) const {
+			size_t start = 0;
+			while( start < size() ) {
+				size_t end = start + 1;
+				while( end < size() && isContiguous(end) )
+					end++;
+
+				if( alignment > 1 ) {
+					size_t alignedStart = start;
+					while( alignedStart < end && !isAligned(alignedStart, alignment) )
+						alignedStart++;
+
+					if( alignedStart > start && alignedStart < end ) {
+						callChunk(callback, start, alignedStart - start, std::index_sequence_for<C...>());
+						start = alignedStart;
+					}
+				}
+
+				callChunk(callback, start, end - start, std::index_sequence_for<C...>());
+				start = end;
+			}
+		}
+
+
+	private:
+		template <size_t ... I>
+		value_type getMatch(size_t index, std::index_sequence<I...>) const {
+			void* const* matchComponents = components.data() + index * NUM_COMPONENT_TYPES;
+			return value_type(entities[index], *static_cast<C*>(matchComponents[I])...);
+		}
+
+
+		/**
+		 * @return	True if each of the match's components directly follows the component of the previous match
+		*/
+		bool isContiguous(size_t index) const {
+			void* const* matchComponents = components.data() + index * NUM_COMPONENT_TYPES;
+			void* const* previousComponents = matchComponents - NUM_COMPONENT_TYPES;
+			for( size_t i = 0; i < NUM_COMPONENT_TYPES; i++ ) {
+				if( static_cast<char*>(matchComponents[i]) != static_cast<char*>(previousComponents[i]) + COMPONENT_SIZES[i] )
+					return false;
+			}
+			return true;
+		}
+
+
+		bool isAligned(size_t index, size_t alignment) const {
+			void* const* matchComponents = components.data() + index * NUM_COMPONENT_TYPES;
+			for( size_t i = 0; i < NUM_COMPONENT_TYPES; i++ ) {
+				if( reinterpret_cast<uintptr_t>(matchComponents[i]) % alignment != 0 )
+					return false;
+			}
+			return true;
+		}
+
+
+		template <typename Func, size_t ... I>
+		void callChunk(Func& callback, size_t start, size_t count, std::index_sequence<I...>) const {
+			void* const* chunkComponents = components.data() + start * NUM_COMPONENT_TYPES;
+			callback(entities.data() + start, count, static_cast<C*>(chunkComponents[I])...);
+		}
+
+
+		void reserve(size_t numMatches) {
+			entities.reserve(numMatches);
+			components.reserve(numMatches * NUM_COMPONENT_TYPES);
+		}
+
+
+		void addMatch(Entity* entity, C* ... matchComponents) {
+			entities.push_back(entity);
+			(components.push_back(matchComponents), ...);
+		}
+
+
+	private:
+		std::pmr::vector<Entity*> entities;
+
+		/**
+		 * @brief The components of each match (NUM_COMPONENT_TYPES pointers per match, in the order of C) */
+		std::pmr::vector<void*> components;
+
+		friend class Domain;
+	};
+
+}